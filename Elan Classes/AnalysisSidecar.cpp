@@ -0,0 +1,258 @@
+#include "ElanClassesHeader.h"
+
+namespace
+{
+	const uint32 sidecarMagic = 0x4e414553; // 'SEAN'
+	const size_t headerSize = 40;
+	const size_t sectionEntrySize = 16;
+
+	uint32 sectionId(const char * name) { return ByteOrder::littleEndianInt(name); }
+
+	uint64 fnv1a(uint64 hash, const void * data, size_t size)
+	{
+		const uint8 * bytes = static_cast<const uint8 *>(data);
+
+		for (size_t i = 0; i < size; ++i)
+			hash = (hash ^ bytes[i]) * 0x100000001b3ULL;
+
+		return hash;
+	}
+
+	double readDouble(const char * p)
+	{
+		const uint64 bits = ByteOrder::littleEndianInt64(p);
+		double v;
+		memcpy(&v, &bits, sizeof(v));
+		return v;
+	}
+
+	void padTo8(MemoryOutputStream & output)
+	{
+		while (output.getDataSize() % 8 != 0)
+			output.writeByte(0);
+	}
+}
+
+File AnalysisSidecar::getSidecarFile(const File & source, const File & cacheDirectory)
+{
+	if (cacheDirectory == File())
+		return source.getSiblingFile(source.getFileName() + ".seanalysis");
+
+	const String path = source.getFullPathName();
+	const uint64 hash = fnv1a(0xcbf29ce484222325ULL, path.toRawUTF8(), path.getNumBytesAsUTF8());
+
+	return cacheDirectory.getChildFile(source.getFileNameWithoutExtension() + "_" + String::toHexString(int64(hash)) + ".seanalysis");
+}
+
+AnalysisSidecar::SourceStamp AnalysisSidecar::getStamp(const File & source)
+{
+	SourceStamp stamp;
+	stamp.fileSize = source.getSize();
+	stamp.modificationTime = source.getLastModificationTime().toMilliseconds();
+
+	FileInputStream input(source);
+
+	if (input.failedToOpen())
+		return stamp;
+
+	const int64 edge = 65536;
+	const int64 slice = 4096;
+	const int numSlices = 16;
+
+	uint64 hash = fnv1a(0xcbf29ce484222325ULL, &stamp.fileSize, sizeof(stamp.fileSize));
+	HeapBlock<char> buffer(size_t(edge));
+
+	auto hashRange = [&](int64 start, int64 length)
+	{
+		start = jlimit<int64>(0, stamp.fileSize, start);
+		length = jmin(length, stamp.fileSize - start);
+
+		if (length > 0 && input.setPosition(start))
+			hash = fnv1a(hash, buffer, size_t(jmax(0, input.read(buffer, int(length)))));
+	};
+
+	hashRange(0, edge);
+
+	for (int i = 1; i <= numSlices; ++i)
+		hashRange(stamp.fileSize * i / (numSlices + 1), slice);
+
+	hashRange(stamp.fileSize - edge, edge);
+
+	stamp.contentHash = hash;
+	return stamp;
+}
+
+void AnalysisSidecar::clear()
+{
+	peaks.clear();
+	loudness = LoudnessMeter::Result();
+	rmsWindowSeconds = 0;
+	hasOnsets = false;
+	onsetSettingsHash = 0;
+	onsets.clear();
+}
+
+MemoryBlock AnalysisSidecar::writeToMemory(const SourceStamp & stamp) const
+{
+	vector<std::pair<uint32, MemoryBlock>> sections;
+
+	if (peaks.isBuilt())
+	{
+		MemoryOutputStream s;
+		peaks.writeToStream(s);
+		sections.push_back({ sectionId("PEAK"), s.getMemoryBlock() });
+	}
+
+	if (loudness.isValid)
+	{
+		MemoryOutputStream s;
+		for (double v : { loudness.integrated, loudness.momentaryMax, loudness.shortTermMax, loudness.truePeak, loudness.rmsMax, rmsWindowSeconds })
+			s.writeDouble(v);
+		sections.push_back({ sectionId("LOUD"), s.getMemoryBlock() });
+	}
+
+	if (hasOnsets)
+	{
+		MemoryOutputStream s;
+		s.writeInt64(int64(onsetSettingsHash));
+		s.writeInt64(int64(onsets.size()));
+		for (double time : onsets)
+			s.writeDouble(time);
+		sections.push_back({ sectionId("ONST"), s.getMemoryBlock() });
+	}
+
+	MemoryOutputStream output;
+	output.writeInt(int(sidecarMagic));
+	output.writeInt(int(currentVersion));
+	output.writeInt64(stamp.fileSize);
+	output.writeInt64(stamp.modificationTime);
+	output.writeInt64(int64(stamp.contentHash));
+	output.writeInt(int(sections.size()));
+	output.writeInt(0);
+
+	int64 offset = int64(headerSize + sections.size() * sectionEntrySize);
+
+	for (const auto & section : sections)
+	{
+		output.writeInt(int(section.first));
+		output.writeInt(int(section.second.getSize()));
+		output.writeInt64(offset);
+		offset += (int64(section.second.getSize()) + 7) / 8 * 8;
+	}
+
+	for (const auto & section : sections)
+	{
+		output.write(section.second.getData(), section.second.getSize());
+		padTo8(output);
+	}
+
+	return output.getMemoryBlock();
+}
+
+bool AnalysisSidecar::readFromMemory(AnalysisSidecar & result, const void * data, size_t size, const SourceStamp & expected)
+{
+	result.clear();
+
+	if (size < headerSize)
+		return false;
+
+	const char * bytes = static_cast<const char *>(data);
+	auto readInt = [bytes](size_t pos) { return ByteOrder::littleEndianInt(bytes + pos); };
+	auto readInt64 = [bytes](size_t pos) { return int64(ByteOrder::littleEndianInt64(bytes + pos)); };
+
+	if (readInt(0) != sidecarMagic || readInt(4) != currentVersion)
+		return false;
+
+	SourceStamp stamp;
+	stamp.fileSize = readInt64(8);
+	stamp.modificationTime = readInt64(16);
+	stamp.contentHash = uint64(readInt64(24));
+
+	if (!(stamp == expected))
+		return false;
+
+	const size_t numSections = readInt(32);
+
+	if (headerSize + numSections * sectionEntrySize > size)
+		return false;
+
+	for (size_t i = 0; i < numSections; ++i)
+	{
+		const size_t entry = headerSize + i * sectionEntrySize;
+		const uint32 id = readInt(entry);
+		const size_t sectionSize = readInt(entry + 4);
+		const int64 offset = readInt64(entry + 8);
+
+		if (offset < 0 || size_t(offset) + sectionSize > size)
+			return false;
+
+		const char * section = bytes + offset;
+
+		if (id == sectionId("PEAK"))
+		{
+			if (!result.peaks.readFromMemory(section, sectionSize))
+				return false;
+		}
+		else if (id == sectionId("LOUD") && sectionSize >= 6 * sizeof(double))
+		{
+			double v[6];
+			for (int k = 0; k < 6; ++k)
+				v[k] = readDouble(section + k * sizeof(double));
+
+			result.loudness.isValid = true;
+			result.loudness.integrated = v[0];
+			result.loudness.momentaryMax = v[1];
+			result.loudness.shortTermMax = v[2];
+			result.loudness.truePeak = v[3];
+			result.loudness.rmsMax = v[4];
+			result.rmsWindowSeconds = v[5];
+		}
+		else if (id == sectionId("ONST") && sectionSize >= 16)
+		{
+			const size_t count = size_t(ByteOrder::littleEndianInt64(section + 8));
+
+			if (count > (sectionSize - 16) / 8)
+				return false;
+
+			result.hasOnsets = true;
+			result.onsetSettingsHash = ByteOrder::littleEndianInt64(section);
+			result.onsets.resize(count);
+			for (size_t k = 0; k < count; ++k)
+				result.onsets[k] = readDouble(section + 16 + k * 8);
+		}
+	}
+
+	return true;
+}
+
+bool AnalysisSidecar::load(const File & source, const File & cacheDirectory)
+{
+	const File sidecar = getSidecarFile(source, cacheDirectory);
+
+	if (!sidecar.existsAsFile())
+		return false;
+
+	MemoryMappedFile mapped(sidecar, MemoryMappedFile::readOnly);
+
+	if (mapped.getData() == nullptr)
+		return false;
+
+	return readFromMemory(*this, mapped.getData(), mapped.getSize(), getStamp(source));
+}
+
+bool AnalysisSidecar::save(const File & source, const File & cacheDirectory) const
+{
+	const File sidecar = getSidecarFile(source, cacheDirectory);
+
+	if (cacheDirectory != File() && !cacheDirectory.createDirectory())
+		return false;
+
+	const MemoryBlock data = writeToMemory(getStamp(source));
+
+	TemporaryFile temp(sidecar);
+
+	if (!temp.getFile().replaceWithData(data.getData(), data.getSize()))
+		return false;
+
+	return temp.overwriteTargetFileWithTemporary();
+}
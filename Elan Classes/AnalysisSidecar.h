@@ -0,0 +1,67 @@
+#pragma once
+
+/**
+* Analysis results for one audio file, stored in a small binary file next to it or in a cache
+* directory, so unchanged files don't have to be analysed again.
+*
+* The sidecar records the size, modification time and a content hash of the audio file it was
+* made from. load() rejects it if any of them changed. The hash covers the first and last 64 kB
+* and 16 slices in between, enough to notice a file being replaced without reading all of it.
+*
+* Layout, all little endian, every section starts on an 8 byte boundary so a mapped file can be
+* read in place:
+*
+*   header   magic 'SEAN', version, file size, mtime (ms), content hash, section count
+*   table    per section: id, size, offset from the start of the file
+*   'PEAK'   PeakPyramid, see PeakPyramid::writeToStream
+*   'LOUD'   LoudnessMeter::Result and the peak RMS window as doubles
+*   'ONST'   onset settings hash, count, onset times in seconds as doubles
+*
+* Unknown sections are skipped, so older readers can open newer files of the same version.
+* Nothing here needs REAPER.
+*/
+class AnalysisSidecar
+{
+public:
+	static const uint32 currentVersion = 2;
+
+	PeakPyramid peaks;
+
+	LoudnessMeter::Result loudness;
+	double rmsWindowSeconds = 0; // sliding window of loudness.rmsMax
+
+	// Onsets in seconds from the start of the source, found with the settings of onsetSettingsHash.
+	// hasOnsets tells an empty result apart from none stored.
+	bool hasOnsets = false;
+	uint64 onsetSettingsHash = 0;
+	vector<double> onsets;
+
+	/** The sidecar file of source, next to it, or named after a hash of its path inside cacheDirectory. */
+	static File getSidecarFile(const File & source, const File & cacheDirectory = File());
+
+	/** Size, mtime and content hash of source as stored in the header. */
+	struct SourceStamp
+	{
+		int64 fileSize = 0;
+		int64 modificationTime = 0;
+		uint64 contentHash = 0;
+
+		bool operator==(const SourceStamp & other) const
+		{
+			return fileSize == other.fileSize && modificationTime == other.modificationTime && contentHash == other.contentHash;
+		}
+	};
+
+	static SourceStamp getStamp(const File & source);
+
+	/** Memory maps the sidecar and reads it. Returns false if it is missing, corrupt, of another version or out of date. */
+	bool load(const File & source, const File & cacheDirectory = File());
+
+	/** Writes the sidecar, through a temporary file so a crash never leaves a half written one. */
+	bool save(const File & source, const File & cacheDirectory = File()) const;
+
+	void clear();
+
+	static bool readFromMemory(AnalysisSidecar & result, const void * data, size_t size, const SourceStamp & expected);
+	MemoryBlock writeToMemory(const SourceStamp & stamp) const;
+};
@@ -1,40 +1,50 @@
 #include <vector>
 using std::vector;
+#include <unordered_set>
 #include "Audio.h"
 #include "../Reaper Classes/ReaperClassesHeader.h"
 
 vector<vector<double>> InterleavedToMultichannel(double* input, int channels, int frames)
 {
-    vector<vector<double>> data(channels, vector<double>(channels));
-
-    for (auto& c : data)
-			c.reserve(frames);
+    vector<vector<double>> data(channels);
+    vector<double*> out(channels);
 
     for (int ch = 0; ch < channels; ++ch)
-        for (int x = 0, y = ch; x < frames; ++x, y+=channels)
-            data[ch].push_back(input[y]);
+    {
+        data[ch].resize(frames);
+        out[ch] = data[ch].data();
+    }
 
-    return std::move(data);
-}
+    SampleConverter::deinterleave(input, channels, size_t(frames), out.data());
 
-static const String idCueLabel{ "CueLabel" };
-static const String idCueRegion{ "CueRegion" };
-static const String idCue{ "Cue" };
-static const String idLoop{ "Loop" };
+    return data;
+}
 
-bool WavAudioFile::write(const File& path, vector<double> singleChannelAudio, int sampleRate, int bitDepth)
+namespace
 {
-	std::unique_ptr<juce::AudioSampleBuffer> buffer;
-	buffer.reset(new juce::AudioSampleBuffer(1, singleChannelAudio.size()));
-
-	auto ptr = buffer->getWritePointer(0);
-
-	for (int f = 0; f < singleChannelAudio.size(); ++f)
-		ptr[f] = float(singleChannelAudio[f]);
-
-	WavAudioFormat format;
-	std::unique_ptr<AudioFormatWriter> writer;
+	// Windows can't truncate or replace a file while a view of it is mapped, so a save to the
+	// mapped file unmaps it for the duration and maps the new file again afterwards.
+	struct ScopedUnmap
+	{
+		ScopedUnmap(WavAudioFile & wav, bool isTheMappedFile) : wav(wav), wasMapped(isTheMappedFile && wav.isMemoryMapped())
+		{
+			if (wasMapped)
+				wav.unmap();
+		}
+
+		~ScopedUnmap()
+		{
+			if (wasMapped)
+				wav.mapIntoMemory();
+		}
+
+		WavAudioFile & wav;
+		const bool wasMapped;
+	};
+}
 
+AudioFormatWriter* WavAudioFile::createWriter(const File& path, int sampleRate, int numChannels, int bitDepth)
+{
 	try
 	{
 		FileHelper::createFile(path.getFullPathName(), true);
@@ -42,85 +52,171 @@ bool WavAudioFile::write(const File& path, vector<double> singleChannelAudio, in
 	catch (std::exception& e)
 	{
 		String error = e.what();
+		return nullptr;
+	}
+
+	WavAudioFormat format;
+	return format.createWriterFor(new FileOutputStream(path), sampleRate, numChannels, bitDepth, {}, 0);
+}
+
+// the WAV writer switches the header to RF64 by itself once the data passes 4 GB
+bool WavAudioFile::writeChannels(const File& path, const float* const* channels, int numChannels, int64 numFrames, int sampleRate, int bitDepth)
+{
+	std::unique_ptr<AudioFormatWriter> writer(createWriter(path, sampleRate, numChannels, bitDepth));
+
+	if (writer == nullptr)
 		return false;
+
+	vector<const float*> block(numChannels);
+
+	for (int64 pos = 0; pos < numFrames; pos += writeBlockSize)
+	{
+		const int n = int(jmin<int64>(writeBlockSize, numFrames - pos));
+
+		for (int c = 0; c < numChannels; ++c)
+			block[c] = channels[c] + pos;
+
+		if (!writer->writeFromFloatArrays(block.data(), numChannels, n))
+			return false;
 	}
 
-	writer.reset(format.createWriterFor(new FileOutputStream(path), sampleRate, 1, bitDepth, {}, 0));
+	return true;
+}
+
+bool WavAudioFile::writeChannels(const File& path, const double* const* channels, int numChannels, int64 numFrames, int sampleRate, int bitDepth)
+{
+	std::unique_ptr<AudioFormatWriter> writer(createWriter(path, sampleRate, numChannels, bitDepth));
 
 	if (writer == nullptr)
 		return false;
 
-	writer->writeFromAudioSampleBuffer(*buffer.get(), 0, buffer->getNumSamples());	
+	AudioBuffer<float> buffer(numChannels, int(jmin<int64>(writeBlockSize, jmax<int64>(numFrames, 1))));
+
+	for (int64 pos = 0; pos < numFrames; pos += writeBlockSize)
+	{
+		const int n = int(jmin<int64>(writeBlockSize, numFrames - pos));
+
+		for (int c = 0; c < numChannels; ++c)
+			SampleConverter::convert(channels[c] + pos, buffer.getWritePointer(c), size_t(n));
+
+		if (!writer->writeFromAudioSampleBuffer(buffer, 0, n))
+			return false;
+	}
 
 	return true;
 }
 
-bool WavAudioFile::write(const File& path, vector<vector<double>> multichannelAudio, int sampleRate, int bitDepth)
+bool WavAudioFile::write(const File& path, const vector<double>& singleChannelAudio, int sampleRate, int bitDepth)
 {
-	AudioBuffer<float> buffer(multichannelAudio.size(), multichannelAudio[0].size());
+	return write(path, SampleSpan<const double>(singleChannelAudio.data(), singleChannelAudio.size()), sampleRate, bitDepth);
+}
 
-	auto ptr = buffer.getArrayOfWritePointers();
+bool WavAudioFile::write(const File& path, const vector<float>& singleChannelAudio, int sampleRate, int bitDepth)
+{
+	return write(path, SampleSpan<const float>(singleChannelAudio.data(), singleChannelAudio.size()), sampleRate, bitDepth);
+}
 
-	for (int c = 0; c < multichannelAudio.size(); ++c)
-		for (int f = 0; f < multichannelAudio[0].size(); ++f)
-			ptr[c][f] = float(multichannelAudio[c][f]);
+bool WavAudioFile::write(const File& path, const vector<vector<double>>& multichannelAudio, int sampleRate, int bitDepth)
+{
+	if (multichannelAudio.empty())
+		return false;
 
-	WavAudioFormat format;
-	std::unique_ptr<AudioFormatWriter> writer;
-	writer.reset(format.createWriterFor(new FileOutputStream(path), sampleRate, multichannelAudio.size(), bitDepth, {}, 0));
+	vector<const double*> channels;
+	for (const auto& c : multichannelAudio)
+		channels.push_back(c.data());
 
-	if (writer == nullptr)
+	return writeChannels(path, channels.data(), int(channels.size()), int64(multichannelAudio[0].size()), sampleRate, bitDepth);
+}
+
+bool WavAudioFile::write(const File& path, const vector<vector<float>>& multichannelAudio, int sampleRate, int bitDepth)
+{
+	if (multichannelAudio.empty())
 		return false;
 
-	writer->writeFromAudioSampleBuffer(buffer, 0, buffer.getNumSamples());
+	vector<const float*> channels;
+	for (const auto& c : multichannelAudio)
+		channels.push_back(c.data());
 
-	return true;
+	return writeChannels(path, channels.data(), int(channels.size()), int64(multichannelAudio[0].size()), sampleRate, bitDepth);
 }
 
-WavAudioFile::WavAudioFile(const File& sourceFile)
+bool WavAudioFile::write(const File& path, SampleSpan<const double> singleChannelAudio, int sampleRate, int bitDepth)
 {
-	manager.registerBasicFormats();
+	const double* channels[] = { singleChannelAudio.data() };
+	return writeChannels(path, channels, 1, int64(singleChannelAudio.size()), sampleRate, bitDepth);
+}
 
-	fileInfo.path = sourceFile;
+bool WavAudioFile::write(const File& path, SampleSpan<const float> singleChannelAudio, int sampleRate, int bitDepth)
+{
+	const float* channels[] = { singleChannelAudio.data() };
+	return writeChannels(path, channels, 1, int64(singleChannelAudio.size()), sampleRate, bitDepth);
+}
 
-	readFileInfo();
-	setClipInfoToFileInfo();
+bool WavAudioFile::write(const File& path, MultichannelSpan<const double> audio, int sampleRate, int bitDepth)
+{
+	vector<const double*> channels;
+	for (int c = 0; c < audio.getNumChannels(); ++c)
+		channels.push_back(audio.getChannelPointer(c));
 
-	if (reader)
-	{
-		metadata = reader->metadataValues;
-		loadMetaData();
-		didRead = true;
-	}
+	return writeChannels(path, channels.data(), int(channels.size()), int64(audio.getNumFrames()), sampleRate, bitDepth);
+}
+
+bool WavAudioFile::write(const File& path, MultichannelSpan<const float> audio, int sampleRate, int bitDepth)
+{
+	vector<const float*> channels;
+	for (int c = 0; c < audio.getNumChannels(); ++c)
+		channels.push_back(audio.getChannelPointer(c));
 
-	reader = nullptr;
+	return writeChannels(path, channels.data(), int(channels.size()), int64(audio.getNumFrames()), sampleRate, bitDepth);
+}
+
+WavAudioFile::WavAudioFile(const File& sourceFile)
+	: sourceFile(sourceFile)
+{
+	open();
 }
 
 WavAudioFile::WavAudioFile(const File& sourceFile, double startOffset, double length)
   :
-  clipStart(startOffset), clipLength(length)
+  sourceFile(sourceFile), clipStart(startOffset), clipLength(length)
 {
-  manager.registerBasicFormats();
-
-  reader = manager.createReaderFor(sourceFile);
-  sampleRate = reader->sampleRate;
-
-  if (reader)
-  {
-    metadata = reader->metadataValues;
-    loadMetaData();
-    didRead = true;
-  }
+  open();
 }
 
-StringPairArray WavAudioFile::getMetadata() const
+void WavAudioFile::open()
 {
-  return metadata;
+	fileInfo.path = sourceFile;
+
+	// WAV headers and metadata are parsed directly, other formats need a reader to get the file info
+	if (riff.read(sourceFile) && riff.format.sampleRate > 0)
+	{
+		fileInfo.sampleRate = riff.format.sampleRate;
+		fileInfo.bitDepth = riff.format.bitsPerSample;
+		fileInfo.numChannels = riff.format.numChannels;
+		fileInfo.numFrames = int(riff.format.getNumFrames());
+		fileInfo.numSamples = fileInfo.numFrames * fileInfo.numChannels;
+		fileInfo.length = fileInfo.numFrames / fileInfo.sampleRate;
+		audioFileWasRead = true;
+	}
+	else
+	{
+		readFileInfo();
+		reader.reset();
+	}
+
+	setClipInfoToFileInfo();
+
+	if (audioFileWasRead)
+	{
+		sampleRate = fileInfo.sampleRate;
+		loadMetaData();
+		didRead = true;
+	}
 }
 
 double WavAudioFile::getSampleRate() const
 {
-  return reader->sampleRate;
+  return fileInfo.sampleRate;
 }
 
 //void WavAudioFile::setSampleStart(int s)
@@ -134,24 +230,84 @@ double WavAudioFile::getSampleRate() const
 
 double WavAudioFile::getFileLengthInSeconds() const
 {
-  if (reader->sampleRate == 0.0)
+  if (fileInfo.sampleRate == 0.0)
     return 0.0;
 
-  return double(reader->lengthInSamples) / reader->sampleRate;
+  return double(fileInfo.numFrames) / fileInfo.sampleRate;
 }
 
 int64 WavAudioFile::getLengthInSamples() const
 {
-  return reader->lengthInSamples;
+  return fileInfo.numFrames;
 }
 
 void WavAudioFile::loadAudio()
 {
-	readFileInfo();
+	if (mappedReader == nullptr)
+		readFileInfo();
+
+	updateClipWindow();
 
 	audio = new juce::AudioSampleBuffer(fileInfo.numChannels, clipInfo.numFrames);
-	reader->read(audio, 0, clipInfo.numFrames, clipInfo.startSample, true, true);
-	reader = nullptr;
+
+	if (mappedReader != nullptr)
+		mappedReader->read(audio, 0, clipInfo.numFrames, clipInfo.startSample, true, true);
+	else if (reader != nullptr)
+		reader->read(audio, 0, clipInfo.numFrames, clipInfo.startSample, true, true);
+
+	reader.reset();
+}
+
+bool WavAudioFile::mapIntoMemory()
+{
+	if (mappedReader != nullptr)
+		return true;
+
+	WavAudioFormat format;
+	mappedReader = format.createMemoryMappedReader(fileInfo.path);
+
+	// the whole data chunk is mapped once, the clip window then selects part of it
+	if (mappedReader == nullptr || !mappedReader->mapEntireFile())
+	{
+		mappedReader = nullptr;
+		return false;
+	}
+
+	return true;
+}
+
+Range<int64> WavAudioFile::getClipRange() const
+{
+	const int64 fileFrames = fileInfo.numFrames;
+	const int64 start = jlimit<int64>(0, fileFrames, int64(std::round(clipStart * fileInfo.sampleRate)));
+
+	if (clipLength <= 0.0)
+		return { start, fileFrames };
+
+	return { start, jlimit<int64>(start, fileFrames, start + int64(std::round(clipLength * fileInfo.sampleRate))) };
+}
+
+bool WavAudioFile::readClip(AudioBuffer<float>& destination, int destStartFrame, int64 startFrameInClip, int numFrames)
+{
+	const auto clip = getClipRange();
+	const int64 start = clip.getStart() + startFrameInClip;
+
+	jassert(startFrameInClip >= 0 && start + numFrames <= clip.getEnd()); // reading outside the clip window
+	jassert(destStartFrame + numFrames <= destination.getNumSamples());
+
+	if (mappedReader != nullptr)
+	{
+		mappedReader->read(&destination, destStartFrame, numFrames, start, true, true);
+		return true;
+	}
+
+	auto fileReader = AudioReaderPool::getInstance().getReader(fileInfo.path);
+
+	if (fileReader == nullptr)
+		return false;
+
+	fileReader->read(&destination, destStartFrame, numFrames, start, true, true);
+	return true;
 }
 
 int WavAudioFile::getSamplePosition(double timeInSeconds) const
@@ -161,6 +317,22 @@ int WavAudioFile::getSamplePosition(double timeInSeconds) const
 
 double WavAudioFile::getPeakValue()
 {
+  // scan the mapped clip window in place
+  if (mappedReader != nullptr)
+  {
+    const auto clip = getClipRange();
+    HeapBlock<Range<float>> levels(fileInfo.numChannels, true);
+
+    mappedReader->readMaxLevels(clip.getStart(), clip.getLength(), levels, fileInfo.numChannels);
+
+    double v = 0.0;
+
+    for (int chan = 0; chan < fileInfo.numChannels; ++chan)
+      v = max<double>(v, max(std::fabs(levels[chan].getStart()), std::fabs(levels[chan].getEnd())));
+
+    return v;
+  }
+
   ensureAudioLoaded();
 
   auto data = audio->getArrayOfReadPointers();
@@ -182,275 +354,253 @@ void WavAudioFile::ensureAudioLoaded()
     loadAudio();
 }
 
-int WavAudioFile::getNumSampleLoops() const
+bool WavAudioFile::saveChanges(const File& destination)
 {
-  return metadata["NumSampleLoops"].getIntValue();
-}
+  // read the clip before the source may be moved out of the way
+  ensureAudioLoaded();
 
-int WavAudioFile::getNumCueRegions() const
-{
-  return metadata["NumCueRegions"].getIntValue();
-}
+  if (audio == nullptr)
+  {
+    jassertfalse; // we must have audio loaded.
+    return false;
+  }
 
-int WavAudioFile::getNumCueLabels() const
-{
-  return metadata["NumCueLabels"].getIntValue();
-}
+  ScopedUnmap unmapped(*this, destination == fileInfo.path);
 
-int WavAudioFile::getNumCuePoints() const
-{
-  return metadata["NumCuePoints"].getIntValue();
-}
+  createMetaDataFromArrays();
 
-bool WavAudioFile::saveChanges(const File& destination)
-{
-  if (destination == sourceFile)
-  {
-    Random random;
-    File newSource;
+  // written next to the destination and moved over it at the end, so the destination may be the source
+  TemporaryFile temp(destination);
 
-    do { newSource = sourceFile.getSiblingFile("tmp_" + String(random.nextInt64()) + ".wav"); } while (newSource.existsAsFile());
+  {
+    WavAudioFormat wavFormat;
 
-    auto result = sourceFile.moveFileTo(newSource);
+    ScopedPointer<AudioFormatWriter> writer = wavFormat.createWriterFor(new FileOutputStream(temp.getFile()),
+      fileInfo.sampleRate, fileInfo.numChannels, fileInfo.bitDepth, {}, 0);
 
-    if (!result)
+    if (!writer)
       return false;
 
-    sourceFile = newSource;
+    if (!writer->writeFromAudioSampleBuffer(*audio, 0, audio->getNumSamples()))
+      return false;
   }
 
-  createMetaDataFromArrays();
+  // the writer has finished the file, the metadata chunks go after it
+  if (!newRiff.patchFile(temp.getFile()))
+    return false;
 
-  //if (destination.existsAsFile())
-  //	return false;
+  AudioReaderPool::getInstance().closeReaders(destination);
 
-  ensureAudioLoaded();
-  //ScopedPointer<AudioFormatReader> reader = manager.createReaderFor(sourceFile);
+  return temp.overwriteTargetFileWithTemporary();
+}
 
-  if (reader)
-  {
-    WavAudioFormat wavFormat;
+bool WavAudioFile::saveMetadataChanges()
+{
+  const auto clip = getClipRange();
 
-    ScopedPointer<AudioFormatWriter> writer = wavFormat.createWriterFor(new FileOutputStream(destination),
-      reader->sampleRate, reader->numChannels, reader->bitsPerSample, newMetadata, 0);
+  // marker offsets are written relative to the clip, so only a whole file clip can keep its audio
+  const bool isWholeFile = clip.getStart() == 0 && clip.getLength() == riff.format.getNumFrames();
 
-    if (!writer)
-      return false;
+  if (didRead && isWholeFile && riff.format.dataOffset > 0)
+  {
+    ScopedUnmap unmapped(*this, true);
 
-    if (audio)
-    {
-      auto result = writer->writeFromAudioSampleBuffer(*audio, 0, audio->getNumSamples());
+    createMetaDataFromArrays();
 
-      if (!result)
-        return false;
-    }
-    else
+    AudioReaderPool::getInstance().closeReaders(sourceFile);
+
+    if (newRiff.patchFile(sourceFile))
     {
-      jassertfalse; // we must have audio loaded.
-      return false;
+      // keep the chunk layout current for the next save
+      riff.read(sourceFile);
+      return true;
     }
   }
-  else
-  {
+
+  return saveChanges(sourceFile);
+}
+
+bool WavAudioFile::moveIntoClip(int64& offset, int64& length) const
+{
+  const auto clip = getClipRange();
+
+  if (offset > clip.getEnd() || offset + length < clip.getStart())
     return false;
-  }
 
+  const int64 start = jmax(offset, clip.getStart());
+  const int64 end = jmin(offset + length, clip.getEnd());
+
+  offset = start - clip.getStart();
+  length = end - start;
   return true;
 }
 
-String WavAudioFile::getStringValue(const String& prefix, int num, const String& postfix) const
+Array<WavAudioFile::CuePoint> WavAudioFile::getCuePointsInClip() const
 {
-  return metadata[prefix + String(num) + postfix];
+  Array<CuePoint> result;
+
+  for (auto cue : cuePoints)
+  {
+    int64 length = 0;
+    if (moveIntoClip(cue.offset, length))
+      result.add(cue);
+  }
+
+  return result;
 }
 
-int64 WavAudioFile::getIntValue(const String& prefix, int num, const String& postfix) const
+Array<WavAudioFile::Region> WavAudioFile::getRegionsInClip() const
 {
-  return metadata[prefix + String(num) + postfix].getLargeIntValue();
+  Array<Region> result;
+
+  for (auto region : regions)
+    if (moveIntoClip(region.offset, region.length))
+      result.add(region);
+
+  return result;
 }
 
 void WavAudioFile::loadMetaData()
 {
-  //for (int i = 0; i < getNumSampleLoops(); ++i)
-  //	loops.add(getSampleLoop(i));
+  // ids used by loops, their cues are written again from the loops on save
+  std::unordered_set<uint32> loopIdentifiers;
 
-  for (int i = 0; i < getNumCueRegions(); ++i)
-    regions.add(getCueRegion(i));
-
-  for (int i = 0; i < getNumCuePoints(); ++i)
+  for (const auto& l : riff.sampler.loops)
   {
-    bool alreadyPresent{ false };
+    Loop loop;
+    loop.start = int(l.start);
+    loop.end = int(l.end);
+    loop.type = Loop::LoopType(l.type);
+    loop.fraction = int(l.fraction);
+    loop.playcount = int(l.playCount);
+    loop.cueIdentifier = int(l.identifier);
+    loop.label = riff.getLabel(l.identifier);
+    loops.add(loop);
+
+    loopIdentifiers.insert(l.identifier);
+  }
 
-    auto cuePoint = getCuePoint(i);
+  // a cue with an ltxt length is a region
+  for (const auto& ltxt : riff.labelledTexts)
+  {
+    const auto* cue = riff.getCue(ltxt.identifier);
 
-    for (auto &r : regions)
-      if (r.label == cuePoint.label && r.offset == cuePoint.offset)
-        alreadyPresent = true;
+    if (cue == nullptr)
+    {
+      jassertfalse; // region without a cue point
+      continue;
+    }
 
-    if (!alreadyPresent)
-      cuePoints.add(getCuePoint(i));
+    Region r;
+    r.identifier = int(ltxt.identifier);
+    r.offset = cue->sampleOffset;
+    r.length = ltxt.sampleLength;
+    r.label = riff.getLabel(ltxt.identifier);
+    regions.add(r);
   }
 
-  for (int i = 0; i < getNumSampleLoops(); ++i)
-    loops.add(getSampleLoop(i));
+  for (const auto& cue : riff.cues)
+  {
+    if (riff.getLabelledText(cue.identifier) != nullptr || loopIdentifiers.count(cue.identifier) > 0)
+      continue;
+
+    CuePoint c;
+    c.identifier = int(cue.identifier);
+    c.offset = cue.sampleOffset;
+    c.label = riff.getLabel(cue.identifier);
+    cuePoints.add(c);
+  }
 }
 
 void WavAudioFile::createNewRegions()
 {
-  int regionId{ 0 };
-
-  for (auto& r : regions)
+  for (auto& r : getRegionsInClip())
   {
     CuePoint cue;
     cue.offset = r.offset;
     cue.label = r.label;
     newCues.add(cue);
 
-    newMetadata.set(idCueRegion + String(regionId) + "Identifier", String(newCues.size()));
-    newMetadata.set(idCueRegion + String(regionId) + "SampleLength", String(r.length));
-    newMetadata.set(idCueRegion + String(regionId) + "SampleLength", String(r.length));
-
-    regionId++;
+    WavMetadata::LabelledText ltxt;
+    ltxt.identifier = uint32(newCues.size());
+    ltxt.sampleLength = uint32(r.length);
+    newRiff.labelledTexts.push_back(ltxt);
   }
-
-  newMetadata.set("NumCueRegions", String(regionId));
 }
 
 void WavAudioFile::addAdditionalCuePoints()
 {
-  for (auto & cue : cuePoints)
+  for (auto & cue : getCuePointsInClip())
     newCues.add(cue);
 }
 
 void WavAudioFile::createNewCuePoints()
 {
-  int cueIndex{ 0 };
+  uint32 identifier{ 1 };
 
   for (auto & r : newCues)
   {
-    String baseCue = idCue + String(cueIndex);
-
-    /* JUCE applies default values for data we don't provide here, e.g. ChunkID */
-    newMetadata.set(baseCue + "Identifier", String(cueIndex + 1));
-    newMetadata.set(baseCue + "Offset", String(r.offset));
-    newMetadata.set(baseCue + "Order", String(r.offset));
-
-    String baseLabel = idCueLabel + String(cueIndex);
-
-    newMetadata.set(baseLabel + "Identifier", String(cueIndex + 1));
-    newMetadata.set(baseLabel + "Text", r.label);
-
-    cueIndex++;
+    WavMetadata::Cue cue;
+    cue.identifier = identifier;
+    cue.order = uint32(r.offset);
+    cue.sampleOffset = uint32(r.offset);
+    newRiff.cues.push_back(cue);
+
+    WavMetadata::Label label;
+    label.identifier = identifier;
+    label.text = r.label;
+    newRiff.labels.push_back(label);
+
+    identifier++;
   }
-
-  newMetadata.set("NumCuePoints", String(cueIndex));
-  newMetadata.set("NumCueLabels", String(cueIndex));
 }
 
 void WavAudioFile::createNewLoops()
 {
-  int sampleLoopId{ 0 };
+  const auto clip = getClipRange();
+
+  // keep the rest of the original sampler chunk, e.g. the unity note
+  newRiff.sampler = riff.sampler;
+  newRiff.sampler.loops.clear();
+  newRiff.hasSampler = riff.hasSampler || !loops.isEmpty();
+
+  if (newRiff.sampler.samplePeriod == 0 && fileInfo.sampleRate > 0)
+    newRiff.sampler.samplePeriod = uint32(1.0e9 / fileInfo.sampleRate);
 
-  for (auto& l : loops)
+  for (auto l : loops)
   {
+    // loops have to fit in the clip completely
+    if (l.start < clip.getStart() || l.end > clip.getEnd())
+      continue;
+
+    l.start -= int(clip.getStart());
+    l.end -= int(clip.getStart());
+
     CuePoint cue;
     cue.offset = l.start;
     cue.label = l.label;
     newCues.add(cue);
 
-    newMetadata.set(idLoop + String(sampleLoopId) + "Identifier", String(newCues.size()));
-    newMetadata.set(idLoop + String(sampleLoopId) + "PlayCount", String(l.playcount));
-    newMetadata.set(idLoop + String(sampleLoopId) + "Fraction", String(l.fraction));
-    newMetadata.set(idLoop + String(sampleLoopId) + "Type", String(int(l.type)));
-    newMetadata.set(idLoop + String(sampleLoopId) + "Start", String(l.start));
-    newMetadata.set(idLoop + String(sampleLoopId) + "End", String(l.end));
-
-    sampleLoopId++;
+    WavMetadata::SampleLoop loop;
+    loop.identifier = uint32(newCues.size());
+    loop.type = uint32(l.type);
+    loop.start = uint32(l.start);
+    loop.end = uint32(l.end);
+    loop.fraction = uint32(l.fraction);
+    loop.playCount = uint32(l.playcount);
+    newRiff.sampler.loops.push_back(loop);
   }
-
-  newMetadata.set("NumSampleLoops", String(sampleLoopId));
 }
 
 void WavAudioFile::createMetaDataFromArrays()
 {
-
-  newMetadata.clear();
+  newRiff.clear();
   newCues.clear();
 
   createNewRegions();
   createNewLoops();
   addAdditionalCuePoints();
   createNewCuePoints();
-}
 
-WavAudioFile::CuePoint WavAudioFile::getCuePoint(int index) const
-{
-  auto base = String("Cue") + String(index);
-
-  CuePoint r;
-  r.offset = getIntValue(idCue, index, "Offset");
-  r.identifier = getIntValue(idCue, index, "Identifier");
-
-  // we also have ChunkID which should normally, it seems, be 'data'.
-  jassert(getIntValue(idCue, index, "ChunkID") == 1635017060L);
-
-  // appears to be zero ... need to check this one...
-  jassert(getIntValue(idCue, index, "ChunkStart") == 0L);
-
-  // The dwBlockStart field specifies the byte offset of the start of the block containing the 
-  // position. This offset is relative to the start of the waveform data within the 'data' or 'slnt' chunk.
-  jassert(getIntValue(idCue, index, "BlockStart") == 0L);
-
-  r.label = getCueLabel(r.identifier);
-
-  return r;
-}
-
-WavAudioFile::CuePoint WavAudioFile::getCuePointByIdentifier(int identifier) const
-{
-  for (int i = 0; i < getNumCuePoints(); ++i)
-  {
-    auto cp = getCuePoint(i);
-
-    if (cp.identifier == identifier)
-      return cp;
-  }
-
-  jassertfalse; // cue point not found
-  return{};
-}
-
-String WavAudioFile::getCueLabel(int identifier) const
-{
-  auto numLabels = getNumCueLabels();
-
-  for (int i = 0; i < numLabels; ++i)
-    if (getIntValue(idCueLabel, i, "Identifier") == identifier)
-      return getStringValue(idCueLabel, i, "Text");
-
-  return String();
-}
-
-WavAudioFile::Region WavAudioFile::getCueRegion(int index) const
-{
-  Region r;
-  r.identifier = getIntValue(idCueRegion, index, "Identifier");
-  r.length = getIntValue(idCueRegion, index, "SampleLength");
-
-  auto cuePoint = getCuePointByIdentifier(r.identifier);
-
-  r.offset = cuePoint.offset;
-  r.label = cuePoint.label;
-  return r;
-}
-
-WavAudioFile::Loop WavAudioFile::getSampleLoop(int index) const
-{
-  Loop r;
-  r.start = getIntValue(idLoop, index, "Start");
-  r.type = Loop::LoopType(getIntValue(idLoop, index, "Type"));
-  r.end = getIntValue(idLoop, index, "End");
-  r.fraction = getIntValue(idLoop, index, "Fraction");
-  r.playcount = getIntValue(idLoop, index, "PlayCount");
-  r.cueIdentifier = getIntValue(idLoop, index, "Identifier");
-  return r;
+  newRiff.updateIndex();
 }
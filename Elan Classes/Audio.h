@@ -4,10 +4,15 @@
 
 #include "../reaper plugin/reaper_plugin_functions.h"
 
+#include "PlanarBuffer.h"
+
 using namespace juce;
 
 using std::vector;
 
+#include "WavMetadata.h"
+#include "AudioReaderPool.h"
+
 
 /**
 * WAV file meta-data decoder.
@@ -77,6 +82,20 @@ public:
     return nullptr;
   }
 
+  /**
+  * Same as create(), but the file's audio is memory mapped instead of decoded into a buffer.
+  * Returns nullptr if the file can't be read or mapped.
+  */
+  static WavAudioFile * createMemoryMapped(const File & file, double startTime, double lengthInSeconds)
+  {
+    ScopedPointer<WavAudioFile> wavAudioFile = new WavAudioFile(file, startTime, lengthInSeconds);
+
+    if (wavAudioFile->isValid() && wavAudioFile->mapIntoMemory())
+      return wavAudioFile.release();
+
+    return nullptr;
+  }
+
   /** Contains cue point, region and label information for all complete regions. */
   Array<Region> regions;
 
@@ -91,17 +110,48 @@ public:
   /**
   * Write the changes to the audio file to disk.  Returns false if the file could not be
   * written.
+  *
+  * Only the clip window is written. Cue points, regions and loops are moved to be relative
+  * to the clip start, regions are trimmed to the window and anything outside it is dropped.
   */
   bool saveChanges(const File & destination);
 
-	static bool write(const File& path, vector<double> singleChannelAudio, int sampleRate, int bitDepth);
-	static bool write(const File& path, vector<vector<double>> multichannelAudio, int sampleRate, int bitDepth);
+  /**
+  * Writes cue points, regions and loops back into the source file without decoding or
+  * re-encoding the audio, only the metadata chunks and the RIFF size are written.
+  *
+  * Falls back to saveChanges(sourceFile) when the clip window isn't the whole file or the
+  * file can't be patched safely. Changes made to the audio buffer are only written by
+  * the fallback.
+  */
+  bool saveMetadataChanges();
+
+  /** Cue points and regions that fall inside the clip window, with offsets relative to the clip start. */
+  Array<CuePoint> getCuePointsInClip() const;
+  Array<Region> getRegionsInClip() const;
+
+	static bool write(const File& path, const vector<double>& singleChannelAudio, int sampleRate, int bitDepth);
+	static bool write(const File& path, const vector<float>& singleChannelAudio, int sampleRate, int bitDepth);
+	static bool write(const File& path, const vector<vector<double>>& multichannelAudio, int sampleRate, int bitDepth);
+	static bool write(const File& path, const vector<vector<float>>& multichannelAudio, int sampleRate, int bitDepth);
+
+	/**
+	* Writes planar audio without copying it first. The writer is fed writeBlockSize frames at
+	* a time, double channels are converted one block at a time, so the memory used does not
+	* grow with the file length. Files past 4 GB are written as RF64.
+	*/
+	static bool write(const File& path, MultichannelSpan<const double> audio, int sampleRate, int bitDepth);
+	static bool write(const File& path, MultichannelSpan<const float> audio, int sampleRate, int bitDepth);
+	static bool write(const File& path, SampleSpan<const double> singleChannelAudio, int sampleRate, int bitDepth);
+	static bool write(const File& path, SampleSpan<const float> singleChannelAudio, int sampleRate, int bitDepth);
+
+	static const int writeBlockSize = 16384;
 
 	WavAudioFile(const File& sourceFile);
 
   WavAudioFile(const File& sourceFile, double startOffset, double length);
-  /** Returns a copy of the metadata as read from the original file.  Used for debugging. */
-  StringPairArray getMetadata() const;
+  /** Returns the metadata chunks as read from the original file.  Used for debugging. */
+  const WavMetadata & getMetadata() const { return riff; }
 
   double getSampleRate() const;
   double getFileLengthInSeconds() const;
@@ -120,30 +170,69 @@ public:
     cuePoints.clear();
   }
 
+  /** Decodes only the clip window into audio. */
   void loadAudio();
 
+	/**
+	* Maps the WAV data chunk into memory once, using JUCE's MemoryMappedAudioFormatReader.
+	* While mapped, setStartTimeInSeconds and setLengthInSeconds only move the clip window
+	* over the mapping, and getPeakValue and readClip read straight from it without
+	* decoding the file into the audio buffer. Returns false if the file can't be mapped.
+	*/
+	bool mapIntoMemory();
+	void unmap() { mappedReader = nullptr; }
+	bool isMemoryMapped() const { return mappedReader != nullptr; }
+
+	/** The clip window in frames, limited to the file. A clip length of 0 runs to the end of the file. */
+	Range<int64> getClipRange() const;
+
+	/**
+	* Reads numFrames of the clip window, starting at startFrameInClip, into destination.
+	* Comes from the mapping when mapped, otherwise from the file.
+	*/
+	bool readClip(AudioBuffer<float> & destination, int destStartFrame, int64 startFrameInClip, int numFrames);
+
   int getSamplePosition(double timeInSeconds) const;
 
+  /**
+  * A loaded audio buffer no longer matches a moved clip window. A mapped file drops it,
+  * ensureAudioLoaded reads the new window when it's needed again, others reload it now.
+  */
+  void clipWindowMoved()
+  {
+    if (audio == nullptr)
+      return;
+
+    if (isMemoryMapped())
+      audio = nullptr;
+    else
+      loadAudio();
+  }
+
   /**
   * Adjust the start time of the sample relative to the start of the
   * audio file (the sample offset)
   */
   void setStartTimeInSeconds(double newStart)
   {
-    if (newStart != clipStart && audio != nullptr)
-      loadAudio();
+    if (newStart == clipStart)
+      return;
 
     clipStart = newStart;
+    updateClipWindow();
+    clipWindowMoved();
   }
 
   void setLengthInSeconds(double newLength)
   {
     jassert(newLength != 0.0);
 
-    if (newLength != clipLength && audio != nullptr)
-      loadAudio();
+    if (newLength == clipLength)
+      return;
 
     clipLength = newLength;
+    updateClipWindow();
+    clipWindowMoved();
   }
 
   /**
@@ -200,11 +289,11 @@ public:
 
 		audioFileWasRead = false;
 
-		reader = manager.createReaderFor(fileInfo.path);
+		reader = AudioReaderPool::getInstance().getReader(fileInfo.path);
 
 		audioFileWasRead = reader != nullptr;
 
-		if (!isValid())
+		if (reader == nullptr)
 		{
 			jassertfalse;
 			return;
@@ -224,19 +313,31 @@ public:
 		clipInfo.numFrames = fileInfo.numFrames;
 		clipInfo.sampleRate = fileInfo.sampleRate;
 		clipInfo.bitDepth = fileInfo.bitDepth;
+		updateClipWindow();
+	}
+
+	// keeps clipInfo's start and length in line with the clip window
+	void updateClipWindow()
+	{
+		const auto clip = getClipRange();
+		clipInfo.startSample = int(clip.getStart());
+		clipInfo.numFrames = int(clip.getLength());
 	}
 
 	void ensureAudioLoaded();
 	/** Returns true if the source file was read correctly */
-	bool isValid() const { return reader != nullptr && didRead; }
+	bool isValid() const { return didRead; }
 
 private:
 
-  ScopedPointer<AudioFormatReader> reader;
+  AudioReaderPool::Reader reader;
+  ScopedPointer<MemoryMappedAudioFormatReader> mappedReader;
 
-  String getStringValue(const String& prefix, int num, const String& postfix) const;
-  int64 getIntValue(const String& prefix, int num, const String& postfix) const;
+  static AudioFormatWriter* createWriter(const File& path, int sampleRate, int numChannels, int bitDepth);
+  static bool writeChannels(const File& path, const float* const* channels, int numChannels, int64 numFrames, int sampleRate, int bitDepth);
+  static bool writeChannels(const File& path, const double* const* channels, int numChannels, int64 numFrames, int sampleRate, int bitDepth);
 
+  void open();
   void loadMetaData();
   void createNewRegions();
   void addAdditionalCuePoints();
@@ -244,34 +345,22 @@ private:
   void createNewLoops();
   void createMetaDataFromArrays();
 
-  int getNumSampleLoops() const;
-  Loop getSampleLoop(int index) const;
-
-  int getNumCueRegions() const;
-  Region getCueRegion(int index) const;
-
-  int getNumCueLabels() const;
-  String getCueLabel(int index) const;
-
-  int getNumCuePoints() const;
-  CuePoint getCuePoint(int index) const;
-  CuePoint getCuePointByIdentifier(int identifier) const;
+  // moves a range of file frames into the clip window, false if it lies outside of it
+  bool moveIntoClip(int64 & offset, int64 & length) const;
 
   bool didRead{ false };
 	bool audioFileWasRead = false;
 
-  AudioFormatManager manager;
-
   /* input buffer ... */
-  StringPairArray metadata;
+  WavMetadata riff;
 
   /* output buffers... */
-  StringPairArray newMetadata;
+  WavMetadata newRiff;
   Array<CuePoint> newCues;
   File sourceFile;
 
-  double clipStart;
-  double clipLength;
+  double clipStart{ 0.0 };
+  double clipLength{ 0.0 };
   double sampleRate{ 1.0 };
 
   JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(WavAudioFile)
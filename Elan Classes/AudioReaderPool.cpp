@@ -0,0 +1,156 @@
+#include "Audio.h"
+
+// readers opened before the file was modified must not be reused
+static String getPoolKey(const File & file)
+{
+	return file.getFullPathName() + "|" + String(file.getLastModificationTime().toMilliseconds());
+}
+
+AudioReaderPool::Reader & AudioReaderPool::Reader::operator=(Reader && other) noexcept
+{
+	if (this != &other)
+	{
+		reset();
+		pool = other.pool;
+		key = std::move(other.key);
+		reader = std::move(other.reader);
+	}
+	return *this;
+}
+
+void AudioReaderPool::Reader::reset()
+{
+	if (reader != nullptr && pool != nullptr)
+		pool->giveBack(key, std::move(reader));
+
+	reader = nullptr;
+	pool = nullptr;
+}
+
+AudioReaderPool::AudioReaderPool()
+{
+	manager.registerBasicFormats();
+}
+
+AudioReaderPool & AudioReaderPool::getInstance()
+{
+	static AudioReaderPool instance;
+	return instance;
+}
+
+AudioReaderPool::Reader AudioReaderPool::getReader(const File & file)
+{
+	Reader r;
+	r.key = getPoolKey(file);
+
+	{
+		const ScopedLock sl(lock);
+
+		// newest first, it is the one most likely to still be in the OS file cache
+		for (size_t i = idle.size(); i-- > 0;)
+		{
+			if (idle[i].key == r.key)
+			{
+				r.reader = std::move(idle[i].reader);
+				idle.erase(idle.begin() + i);
+				break;
+			}
+		}
+	}
+
+	if (r.reader != nullptr)
+	{
+		++hits;
+	}
+	else
+	{
+		++misses;
+		r.reader.reset(manager.createReaderFor(file));
+	}
+
+	if (r.reader != nullptr)
+		r.pool = this;
+
+	return r;
+}
+
+void AudioReaderPool::giveBack(String key, std::unique_ptr<AudioFormatReader> reader)
+{
+	std::unique_ptr<AudioFormatReader> evicted;
+
+	const ScopedLock sl(lock);
+
+	if (numBatches == 0)
+	{
+		evicted = std::move(reader);
+		return;
+	}
+
+	idle.push_back({ std::move(key), std::move(reader) });
+
+	if (idle.size() > maxIdleReaders)
+	{
+		evicted = std::move(idle.front().reader);
+		idle.erase(idle.begin());
+	}
+}
+
+void AudioReaderPool::beginBatch()
+{
+	const ScopedLock sl(lock);
+	++numBatches;
+}
+
+void AudioReaderPool::endBatch()
+{
+	vector<Entry> closing;
+
+	const ScopedLock sl(lock);
+
+	jassert(numBatches > 0);
+
+	if (--numBatches == 0)
+		closing.swap(idle);
+}
+
+void AudioReaderPool::clear()
+{
+	vector<Entry> closing;
+
+	{
+		const ScopedLock sl(lock);
+		closing.swap(idle);
+	}
+}
+
+void AudioReaderPool::closeReaders(const File & file)
+{
+	const String prefix = file.getFullPathName() + "|";
+	vector<Entry> closing;
+
+	const ScopedLock sl(lock);
+
+	for (size_t i = idle.size(); i-- > 0;)
+	{
+		if (idle[i].key.startsWith(prefix))
+		{
+			closing.push_back(std::move(idle[i]));
+			idle.erase(idle.begin() + i);
+		}
+	}
+}
+
+void AudioReaderPool::setMaxIdleReaders(int n)
+{
+	vector<Entry> closing;
+
+	const ScopedLock sl(lock);
+
+	maxIdleReaders = size_t(jmax(0, n));
+
+	while (idle.size() > maxIdleReaders)
+	{
+		closing.push_back(std::move(idle.front()));
+		idle.erase(idle.begin());
+	}
+}
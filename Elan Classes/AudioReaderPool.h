@@ -0,0 +1,107 @@
+#pragma once
+
+#include <memory>
+
+/**
+* Process-wide AudioFormatManager with the basic formats registered once, and a small pool
+* of open readers keyed by file path and modification time.
+*
+* An AudioFormatReader is not safe to share between threads, so getReader() hands a reader
+* out exclusively. When the Reader handle goes out of scope the reader goes back into the
+* pool, and the next getReader() on the same unchanged file reuses it instead of opening
+* and parsing the file again. A file that was modified since gets a fresh reader.
+*
+* Readers are only kept while a ScopedBatch exists, an open reader keeps Windows from
+* deleting, renaming or rewriting its file. Outside a batch a returned reader is closed.
+*
+* AudioReaderPool::ScopedBatch batch;
+* for (auto & file : folder.findChildFiles(File::findFiles, false, "*.wav"))
+*	scan(WavAudioFile(file));
+*
+* All functions are thread-safe.
+*/
+class AudioReaderPool
+{
+public:
+	class Reader
+	{
+	public:
+		Reader() {}
+		Reader(Reader && other) noexcept : pool(other.pool), key(std::move(other.key)), reader(std::move(other.reader)) {}
+		Reader & operator=(Reader && other) noexcept;
+		~Reader() { reset(); }
+
+		Reader(const Reader &) = delete;
+		Reader & operator=(const Reader &) = delete;
+
+		AudioFormatReader * get() const { return reader.get(); }
+		AudioFormatReader * operator->() const { return reader.get(); }
+		bool operator==(std::nullptr_t) const { return reader == nullptr; }
+		bool operator!=(std::nullptr_t) const { return reader != nullptr; }
+
+		// returns the reader to the pool
+		void reset();
+
+	private:
+		friend class AudioReaderPool;
+
+		AudioReaderPool * pool{ nullptr };
+		String key;
+		std::unique_ptr<AudioFormatReader> reader;
+	};
+
+	// Keeps returned readers open until the last ScopedBatch alive is destroyed, then closes them
+	class ScopedBatch
+	{
+	public:
+		ScopedBatch(AudioReaderPool & pool = AudioReaderPool::getInstance()) : pool(pool) { pool.beginBatch(); }
+		~ScopedBatch() { pool.endBatch(); }
+
+		ScopedBatch(const ScopedBatch &) = delete;
+		ScopedBatch & operator=(const ScopedBatch &) = delete;
+
+	private:
+		AudioReaderPool & pool;
+	};
+
+	static AudioReaderPool & getInstance();
+
+	/** Returns an empty Reader if no registered format can read the file. */
+	Reader getReader(const File & file);
+
+	/** Registered once, createReaderFor can be called from any thread. */
+	AudioFormatManager & getFormatManager() { return manager; }
+
+	/** Closes all pooled readers. */
+	void clear();
+
+	/** Closes the pooled readers of one file, call it before the file is overwritten or deleted. */
+	void closeReaders(const File & file);
+
+	void setMaxIdleReaders(int n);
+
+	int64 getNumHits() const { return hits.get(); }
+	int64 getNumMisses() const { return misses.get(); }
+
+private:
+	AudioReaderPool();
+
+	void giveBack(String key, std::unique_ptr<AudioFormatReader> reader);
+	void beginBatch();
+	void endBatch();
+
+	struct Entry
+	{
+		String key;
+		std::unique_ptr<AudioFormatReader> reader;
+	};
+
+	AudioFormatManager manager;
+
+	CriticalSection lock;
+	vector<Entry> idle; // least recently returned first
+	size_t maxIdleReaders{ 32 };
+	int numBatches{ 0 };
+
+	Atomic<int64> hits, misses;
+};
@@ -3,4 +3,18 @@
 #include "../JuceLibraryCode/JuceHeader.h"
 
 #include "maths.h"
+#include "SampleConversion.h"
+#include "PlanarBuffer.h"
 #include "Audio.h"
+#include "SignalFunctions.h"
+#include "PeakPyramid.h"
+#include "PeakSearch.h"
+#include "SilenceDetector.h"
+#include "RealFFT.h"
+#include "OnsetDetector.h"
+#include "PitchDetector.h"
+#include "Resampler.h"
+#include "MixMatrix.h"
+#include "Loudness.h"
+#include "AnalysisSidecar.h"
+#include "WorkerPool.h"
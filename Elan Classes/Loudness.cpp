@@ -0,0 +1,279 @@
+#include "ElanClassesHeader.h"
+
+LoudnessMeter::LoudnessMeter(double sampleRate, int numChannels, double rmsWindowSeconds)
+	: sampleRate(sampleRate), numChannels(numChannels), rms(jmax(1, int(sampleRate * rmsWindowSeconds)))
+{
+	weights.assign(size_t(numChannels), 1.0);
+
+	if (numChannels == 6)
+		weights = { 1.0, 1.0, 1.0, 0.0, 1.41, 1.41 };
+
+	oversampling = sampleRate < 96000 ? 4 : (sampleRate < 192000 ? 2 : 1);
+	stepFrames = jmax(1, int(std::round(sampleRate * 0.1)));
+
+	initialiseFilters();
+	reset();
+}
+
+void LoudnessMeter::initialiseFilters()
+{
+	const double pi = MathConstants<double>::pi;
+
+	// BS.1770 stage 1, high shelf
+	{
+		const double f0 = 1681.974450955533, gain = 3.999843853973347, q = 0.7071752369554196;
+		const double k = std::tan(pi * f0 / sampleRate);
+		const double vh = std::pow(10.0, gain / 20.0);
+		const double vb = std::pow(vh, 0.4996667741545416);
+		const double a0 = 1.0 + k / q + k * k;
+
+		Biquad& f = prototypeShelf;
+		f.b0 = (vh + vb * k / q + k * k) / a0;
+		f.b1 = 2.0 * (k * k - vh) / a0;
+		f.b2 = (vh - vb * k / q + k * k) / a0;
+		f.a1 = 2.0 * (k * k - 1.0) / a0;
+		f.a2 = (1.0 - k / q + k * k) / a0;
+	}
+
+	// stage 2, high pass
+	{
+		const double f0 = 38.13547087602444, q = 0.5003270373238773;
+		const double k = std::tan(pi * f0 / sampleRate);
+		const double a0 = 1.0 + k / q + k * k;
+
+		Biquad& f = prototypeHighPass;
+		f.b0 = 1.0;
+		f.b1 = -2.0;
+		f.b2 = 1.0;
+		f.a1 = 2.0 * (k * k - 1.0) / a0;
+		f.a2 = (1.0 - k / q + k * k) / a0;
+	}
+
+	// windowed sinc interpolator split into oversampling phases of tapsPerPhase taps
+	const int numTaps = tapsPerPhase * oversampling;
+	polyphase.assign(size_t(numTaps), 0.0);
+
+	if (oversampling > 1)
+	{
+		const double centre = (numTaps - 1) / 2.0;
+
+		for (int n = 0; n < numTaps; ++n)
+		{
+			const double x = (n - centre) / oversampling;
+			const double sinc = x == 0 ? 1.0 : std::sin(pi * x) / (pi * x);
+			const double window = 0.42 - 0.5 * std::cos(2 * pi * n / (numTaps - 1)) + 0.08 * std::cos(4 * pi * n / (numTaps - 1));
+			const int phase = n % oversampling;
+			const int tap = n / oversampling;
+			polyphase[size_t(phase * tapsPerPhase + tap)] = sinc * window;
+		}
+	}
+}
+
+void LoudnessMeter::reset()
+{
+	channels.assign(size_t(numChannels), ChannelState());
+
+	for (auto & c : channels)
+	{
+		c.shelf = prototypeShelf;
+		c.highPass = prototypeHighPass;
+		c.history.assign(size_t(tapsPerPhase), 0.0);
+	}
+
+	stepPosition = 0;
+	stepEnergy = 0;
+	recentSteps.assign(30, 0.0);
+	numSteps = 0;
+	gatingBlocks.clear();
+	momentaryMax = -100;
+	shortTermMax = -100;
+	totalEnergy = 0;
+	totalFrames = 0;
+
+	rms.reset();
+	rmsMax = 0;
+}
+
+void LoudnessMeter::setChannelWeights(const vector<double> & w)
+{
+	jassert(int(w.size()) == numChannels);
+	weights = w;
+	weights.resize(size_t(numChannels), 1.0);
+}
+
+double LoudnessMeter::getStepsMean(size_t count) const
+{
+	double sum = 0;
+
+	for (size_t i = 0; i < count; ++i)
+		sum += recentSteps[(numSteps - 1 - i) % recentSteps.size()];
+
+	return sum / (double(count) * stepFrames);
+}
+
+void LoudnessMeter::finishStep()
+{
+	recentSteps[numSteps % recentSteps.size()] = stepEnergy;
+	++numSteps;
+
+	totalEnergy += stepEnergy;
+	stepEnergy = 0;
+	stepPosition = 0;
+
+	if (numSteps >= 4)
+	{
+		const double momentary = getStepsMean(4);
+		gatingBlocks.push_back(momentary);
+		momentaryMax = jmax(momentaryMax, energyToLUFS(momentary));
+	}
+
+	if (numSteps >= 30)
+		shortTermMax = jmax(shortTermMax, energyToLUFS(getStepsMean(30)));
+}
+
+template <typename t> void LoudnessMeter::process(MultichannelSpan<const t> block)
+{
+	jassert(block.getNumChannels() == numChannels);
+
+	const size_t numFrames = block.getNumFrames();
+	const int numTaps = tapsPerPhase;
+
+	// K-weighting and true peak, one channel at a time, cut at the 100 ms step boundaries
+	for (size_t start = 0; start < numFrames;)
+	{
+		const size_t n = jmin(numFrames - start, size_t(stepFrames - stepPosition));
+
+		for (int ch = 0; ch < numChannels; ++ch)
+		{
+			auto & state = channels[size_t(ch)];
+			const t * x = block.getChannelPointer(ch) + start;
+			double energy = 0;
+			double peak = state.truePeak;
+
+			for (size_t i = 0; i < n; ++i)
+			{
+				const double in = x[i];
+				const double y = state.highPass.process(state.shelf.process(in));
+				energy += y * y;
+
+				peak = jmax(peak, std::abs(in));
+
+				if (oversampling > 1)
+				{
+					state.history[state.historyIndex] = in;
+					state.historyIndex = (state.historyIndex + 1) % size_t(numTaps);
+
+					// the filter is centred between two input samples, so every phase is an interpolated point
+					for (int p = 0; p < oversampling; ++p)
+					{
+						const double * h = polyphase.data() + p * numTaps;
+						double v = 0;
+
+						// tap k pairs with the input k samples before the newest one
+						for (int k = 0; k < numTaps; ++k)
+							v += h[k] * state.history[(state.historyIndex + size_t(numTaps - 1 - k)) % size_t(numTaps)];
+
+						peak = jmax(peak, std::abs(v));
+					}
+				}
+			}
+
+			state.truePeak = peak;
+			stepEnergy += weights[size_t(ch)] * energy;
+		}
+
+		stepPosition += int(n);
+		totalFrames += n;
+		start += n;
+
+		if (stepPosition == stepFrames)
+			finishStep();
+	}
+
+	// sliding RMS of the channel average
+	const double gain = numChannels > 0 ? 1.0 / numChannels : 0.0;
+
+	for (size_t fr = 0; fr < numFrames; ++fr)
+	{
+		double mono = 0;
+		for (int ch = 0; ch < numChannels; ++ch)
+			mono += block.getChannelPointer(ch)[fr];
+
+		const double value = rms.process(mono * gain);
+
+		if (rms.isWindowFull())
+			rmsMax = jmax(rmsMax, value);
+	}
+}
+
+LoudnessMeter::Result LoudnessMeter::getResult() const
+{
+	Result r;
+
+	if (totalFrames == 0)
+		return r;
+
+	r.isValid = true;
+	r.momentaryMax = momentaryMax;
+	r.shortTermMax = shortTermMax;
+	r.rmsMax = rms.isWindowFull() ? rmsMax : rms.getRMS();
+
+	for (const auto & c : channels)
+		r.truePeak = jmax(r.truePeak, c.truePeak);
+
+	if (gatingBlocks.empty())
+	{
+		// shorter than one 400 ms block, measure everything as one block
+		const double meanSquare = (totalEnergy + stepEnergy) / double(totalFrames);
+		r.integrated = energyToLUFS(meanSquare);
+		r.momentaryMax = r.integrated;
+		r.shortTermMax = r.integrated;
+		return r;
+	}
+
+	if (numSteps < 30)
+		r.shortTermMax = energyToLUFS(getStepsMean(numSteps));
+
+	// absolute gate at -70 LUFS, then relative gate 10 LU below the mean of what passed
+	double sum = 0;
+	size_t count = 0;
+	const double absoluteGate = std::pow(10.0, (-70.0 + 0.691) / 10.0);
+
+	for (double e : gatingBlocks)
+		if (e > absoluteGate)
+		{
+			sum += e;
+			++count;
+		}
+
+	if (count == 0)
+		return r;
+
+	const double relativeGate = sum / count * std::pow(10.0, -10.0 / 10.0);
+	sum = 0;
+	count = 0;
+
+	for (double e : gatingBlocks)
+		if (e > absoluteGate && e > relativeGate)
+		{
+			sum += e;
+			++count;
+		}
+
+	if (count > 0)
+		r.integrated = energyToLUFS(sum / count);
+
+	return r;
+}
+
+template <typename t> LoudnessMeter::Result measureLoudness(MultichannelSpan<const t> audio, double sampleRate, double rmsWindowSeconds)
+{
+	LoudnessMeter meter(sampleRate, audio.getNumChannels(), rmsWindowSeconds);
+	meter.process(audio);
+	return meter.getResult();
+}
+
+template void LoudnessMeter::process(MultichannelSpan<const float>);
+template void LoudnessMeter::process(MultichannelSpan<const double>);
+template LoudnessMeter::Result measureLoudness(MultichannelSpan<const float>, double, double);
+template LoudnessMeter::Result measureLoudness(MultichannelSpan<const double>, double, double);
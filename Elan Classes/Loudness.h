@@ -0,0 +1,99 @@
+#pragma once
+
+/**
+* EBU R128 / ITU-R BS.1770 loudness, true peak and sliding window RMS, measured in one pass
+* over blocks of planar audio of any size.
+*
+* K-weighting is the two biquads of BS.1770 with coefficients derived for the actual sample
+* rate. The signal is summed in 100 ms steps; momentary loudness is the mean of the last 4
+* steps, short-term of the last 30, and integrated loudness gates the 400 ms momentary blocks
+* at -70 LUFS and then 10 LU below their mean. Audio shorter than 400 ms is measured as one
+* block so short one-shots still get a value.
+*
+* True peak oversamples 4x below 96 kHz and 2x below 192 kHz with a windowed sinc of 12 taps per phase.
+* The RMS is that of the channel average over a sliding window, like AUDIOFUNCTION::getPeakRMS.
+*
+* Channel weights follow BS.1770 for 6 channels (L R C LFE Ls Rs, LFE ignored, surrounds +1.5 dB),
+* every channel counts fully otherwise. setChannelWeights overrides that.
+*/
+class LoudnessMeter
+{
+public:
+	struct Result
+	{
+		bool isValid = false;
+		double integrated = -100;   // LUFS
+		double momentaryMax = -100; // LUFS
+		double shortTermMax = -100; // LUFS
+		double truePeak = 0;        // linear
+		double rmsMax = 0;          // linear, sliding window
+	};
+
+	LoudnessMeter(double sampleRate, int numChannels, double rmsWindowSeconds = 0.3);
+
+	void reset();
+	void setChannelWeights(const vector<double> & weights);
+
+	template <typename t> void process(MultichannelSpan<const t> block);
+
+	Result getResult() const;
+
+	static double energyToLUFS(double meanSquare) { return meanSquare > 0 ? -0.691 + 10.0 * std::log10(meanSquare) : -100.0; }
+
+protected:
+	struct Biquad
+	{
+		double b0 = 1, b1 = 0, b2 = 0, a1 = 0, a2 = 0;
+		double z1 = 0, z2 = 0;
+
+		double process(double x)
+		{
+			const double y = b0 * x + z1;
+			z1 = b1 * x - a1 * y + z2;
+			z2 = b2 * x - a2 * y;
+			return y;
+		}
+	};
+
+	struct ChannelState
+	{
+		Biquad shelf, highPass;
+		vector<double> history; // last tapsPerPhase input samples for the true peak filter
+		size_t historyIndex = 0;
+		double truePeak = 0;
+	};
+
+	double sampleRate;
+	int numChannels;
+	vector<double> weights;
+	vector<ChannelState> channels;
+	Biquad prototypeShelf, prototypeHighPass; // coefficients, copied into every channel on reset
+
+	// K-weighted energy in 100 ms steps
+	int stepFrames = 0;
+	int stepPosition = 0;
+	double stepEnergy = 0;
+	vector<double> recentSteps; // ring of the last 30 steps
+	size_t numSteps = 0;
+	vector<double> gatingBlocks; // mean square of every 400 ms block
+	double momentaryMax = -100;
+	double shortTermMax = -100;
+	double totalEnergy = 0;
+	size_t totalFrames = 0;
+
+	// true peak
+	int oversampling = 1;
+	int tapsPerPhase = 12;
+	vector<double> polyphase; // [phase * tapsPerPhase + tap]
+
+	// sliding RMS of the channel average
+	SlidingWindowRMS rms;
+	double rmsMax = 0;
+
+	void initialiseFilters();
+	void finishStep();
+	double getStepsMean(size_t count) const;
+};
+
+// Measures a whole buffer in one go, use getChannelRange() on the span to pick channels.
+template <typename t> LoudnessMeter::Result measureLoudness(MultichannelSpan<const t> audio, double sampleRate, double rmsWindowSeconds = 0.3);
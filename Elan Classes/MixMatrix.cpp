@@ -0,0 +1,143 @@
+#include "ElanClassesHeader.h"
+
+MixMatrix::MixMatrix(int numInputs, int numOutputs)
+	: numInputs(jmax(0, numInputs)), numOutputs(jmax(0, numOutputs))
+{
+	gains.assign(size_t(this->numInputs) * size_t(this->numOutputs), 0.0);
+	terms.resize(size_t(this->numOutputs));
+}
+
+MixMatrix MixMatrix::downmix(const vector<int> & channels, int numInputs, double gain)
+{
+	MixMatrix m(numInputs, 1);
+
+	for (int ch : channels)
+		if (isPositiveAndBelow(ch, numInputs))
+			m.gains[size_t(ch)] = gain;
+
+	m.updateTerms();
+	return m;
+}
+
+MixMatrix MixMatrix::average(int firstChannel, int numChannels, int numInputs)
+{
+	const int first = jlimit(0, numInputs, firstChannel);
+	const int last = jlimit(first, numInputs, firstChannel + numChannels);
+
+	vector<int> channels;
+	for (int ch = first; ch < last; ++ch)
+		channels.push_back(ch);
+
+	return downmix(channels, numInputs, channels.empty() ? 0.0 : 1.0 / channels.size());
+}
+
+MixMatrix MixMatrix::select(int firstChannel, int numChannels, int numInputs)
+{
+	MixMatrix m(numInputs, jmax(0, numChannels));
+
+	for (int o = 0; o < m.numOutputs; ++o)
+		if (isPositiveAndBelow(firstChannel + o, numInputs))
+			m.gains[size_t(o * numInputs + firstChannel + o)] = 1.0;
+
+	m.updateTerms();
+	return m;
+}
+
+MixMatrix MixMatrix::fromChannelString(const String & channelString, int numInputs)
+{
+	vector<int> channels;
+
+	for (const auto & token : StringArray::fromTokens(channelString, "|", ""))
+	{
+		const String s = token.trim();
+
+		if (s.isEmpty())
+			continue;
+
+		if (!s.containsOnly("0123456789"))
+		{
+			jassertfalse; // string is not a number
+			continue;
+		}
+
+		const int ch = s.getIntValue() - 1; // 1 base to 0 base
+
+		if (!isPositiveAndBelow(ch, numInputs))
+		{
+			jassertfalse; // invalid channel
+			continue;
+		}
+
+		if (std::find(channels.begin(), channels.end(), ch) == channels.end())
+			channels.push_back(ch);
+	}
+
+	if (channels.empty())
+		return average(0, numInputs, numInputs);
+
+	return downmix(channels, numInputs, 1.0 / channels.size());
+}
+
+void MixMatrix::setGain(int output, int input, double gain)
+{
+	jassert(isPositiveAndBelow(output, numOutputs) && isPositiveAndBelow(input, numInputs));
+
+	gains[size_t(output * numInputs + input)] = gain;
+	updateTerms();
+}
+
+void MixMatrix::updateTerms()
+{
+	terms.assign(size_t(numOutputs), {});
+
+	for (int o = 0; o < numOutputs; ++o)
+		for (int i = 0; i < numInputs; ++i)
+			if (gains[size_t(o * numInputs + i)] != 0)
+				terms[size_t(o)].push_back({ i, gains[size_t(o * numInputs + i)] });
+}
+
+template <typename in, typename out> void MixMatrix::apply(MultichannelSpan<const in> input, MultichannelSpan<out> output, bool add) const
+{
+	jassert(input.getNumChannels() >= numInputs && output.getNumChannels() >= numOutputs);
+
+	const size_t numFrames = jmin(input.getNumFrames(), output.getNumFrames());
+
+	for (int o = 0; o < numOutputs; ++o)
+	{
+		out * dst = output.getChannelPointer(o);
+		const auto & list = terms[size_t(o)];
+		size_t next = 0;
+
+		if (!add)
+		{
+			if (list.empty())
+			{
+				std::fill(dst, dst + numFrames, out(0));
+				continue;
+			}
+
+			// the first term overwrites, so the output needs no clearing pass
+			const in * src = input.getChannelPointer(list[0].input);
+			const out gain = out(list[0].gain);
+
+			for (size_t i = 0; i < numFrames; ++i)
+				dst[i] = out(src[i]) * gain;
+
+			next = 1;
+		}
+
+		for (; next < list.size(); ++next)
+		{
+			const in * src = input.getChannelPointer(list[next].input);
+			const out gain = out(list[next].gain);
+
+			for (size_t i = 0; i < numFrames; ++i)
+				dst[i] += out(src[i]) * gain;
+		}
+	}
+}
+
+template void MixMatrix::apply(MultichannelSpan<const float>, MultichannelSpan<float>, bool) const;
+template void MixMatrix::apply(MultichannelSpan<const float>, MultichannelSpan<double>, bool) const;
+template void MixMatrix::apply(MultichannelSpan<const double>, MultichannelSpan<float>, bool) const;
+template void MixMatrix::apply(MultichannelSpan<const double>, MultichannelSpan<double>, bool) const;
@@ -0,0 +1,65 @@
+#pragma once
+
+/**
+* Gain matrix from numInputs planar channels to numOutputs planar channels.
+*
+* Build it once, e.g. from a channel string or a take's channel mode, and apply it to as many
+* buffers as needed. The non-zero gains of each output are collected when the matrix changes,
+* so apply() runs one multiply(-add) loop over contiguous samples per non-zero gain. The loops
+* have no branches or strides and compile to SIMD. apply() writes into the caller's buffer and
+* never allocates. input and output must not overlap.
+*
+* MixMatrix mono = MixMatrix::fromChannelString("1|2", audio.getNumChannels());
+* mono.apply(audio.getData(), MultichannelSpan<double>(out.data(), 1, out.size(), out.size()));
+*/
+class MixMatrix
+{
+public:
+	MixMatrix() {}
+	MixMatrix(int numInputs, int numOutputs);
+
+	// one output, the sum of the listed input channels times gain, channels outside the input are ignored
+	static MixMatrix downmix(const vector<int> & channels, int numInputs, double gain = 1.0);
+
+	// one output averaging [firstChannel, firstChannel + numChannels)
+	static MixMatrix average(int firstChannel, int numChannels, int numInputs);
+
+	// numChannels outputs, copies of inputs [firstChannel, firstChannel + numChannels)
+	static MixMatrix select(int firstChannel, int numChannels, int numInputs);
+
+	// One output averaging the listed channels. Channels are 1-based and separated by '|', e.g. "1|2|4".
+	// Empty selects all channels, invalid or out of range entries are skipped.
+	static MixMatrix fromChannelString(const String & channelString, int numInputs);
+
+	int getNumInputs() const { return numInputs; }
+	int getNumOutputs() const { return numOutputs; }
+
+	double getGain(int output, int input) const { return gains[size_t(output * numInputs + input)]; }
+	void setGain(int output, int input, double gain);
+
+	/**
+	* output = matrix * input for every frame, or output += matrix * input if add is true.
+	* input needs getNumInputs() channels, output getNumOutputs() channels, frames up to the
+	* shorter of the two are processed. Outputs without any gain are cleared, unless adding.
+	*/
+	template <typename in, typename out> void apply(MultichannelSpan<const in> input, MultichannelSpan<out> output, bool add = false) const;
+
+	template <typename in, typename out> void apply(MultichannelSpan<in> input, MultichannelSpan<out> output, bool add = false) const
+	{
+		apply(MultichannelSpan<const in>(input), output, add);
+	}
+
+protected:
+	struct Term
+	{
+		int input;
+		double gain;
+	};
+
+	int numInputs = 0;
+	int numOutputs = 0;
+	vector<double> gains;       // [output * numInputs + input]
+	vector<vector<Term>> terms; // non-zero gains per output
+
+	void updateTerms();
+};
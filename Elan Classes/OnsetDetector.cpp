@@ -0,0 +1,188 @@
+#include "ElanClassesHeader.h"
+
+uint64 OnsetDetector::Settings::getHash() const
+{
+	const String s = String(fftOrder) + " " + String(hopSize) + " " + String(compression, 12) + " " + String(threshold, 12)
+		+ " " + String(meanWindowSeconds, 12) + " " + String(peakWindow) + " " + String(minimumGapSeconds, 12);
+
+	return uint64(s.hashCode64());
+}
+
+OnsetDetector::OnsetDetector(double sampleRate, const Settings & settings)
+	: sampleRate(sampleRate), settings(settings), fft(settings.fftOrder)
+{
+	jassert(settings.hopSize > 0 && settings.hopSize <= fft.getSize());
+
+	const int size = fft.getSize();
+	const double pi = MathConstants<double>::pi;
+
+	// periodic Hann, scaled so a full scale sine peaks near 1 whatever the fft size
+	window.resize(size_t(size));
+	for (int i = 0; i < size; ++i)
+		window[size_t(i)] = (0.5 - 0.5 * std::cos(2.0 * pi * i / size)) * 4.0 / size;
+
+	frame.resize(size_t(size));
+	windowed.resize(size_t(size));
+	magnitudes.resize(size_t(fft.getNumBins()));
+	previousMagnitudes.resize(size_t(fft.getNumBins()));
+
+	reset();
+}
+
+void OnsetDetector::reset()
+{
+	// the first frame is centred on sample 0
+	std::fill(frame.begin(), frame.end(), 0.0);
+	framePosition = fft.getSize() / 2;
+
+	std::fill(previousMagnitudes.begin(), previousMagnitudes.end(), 0.0);
+	totalSamples = 0;
+	flux.clear();
+	onsets.clear();
+}
+
+template <typename t> void OnsetDetector::process(MultichannelSpan<const t> block)
+{
+	const int numChannels = block.getNumChannels();
+	const size_t numFrames = block.getNumFrames();
+
+	if (numChannels == 0)
+		return;
+
+	const double gain = 1.0 / numChannels;
+	const int size = fft.getSize();
+
+	for (size_t fr = 0; fr < numFrames; ++fr)
+	{
+		double mono = 0;
+		for (int ch = 0; ch < numChannels; ++ch)
+			mono += block.getChannelPointer(ch)[fr];
+
+		frame[size_t(framePosition++)] = mono * gain;
+
+		if (framePosition == size)
+			analyseFrame();
+	}
+
+	totalSamples += int64(numFrames);
+}
+
+void OnsetDetector::analyseFrame()
+{
+	const int size = fft.getSize();
+	const int hop = settings.hopSize;
+
+	for (int i = 0; i < size; ++i)
+		windowed[size_t(i)] = frame[size_t(i)] * window[size_t(i)];
+
+	fft.getMagnitudes(windowed.data(), magnitudes.data());
+
+	double sum = 0;
+	for (size_t k = 0; k < magnitudes.size(); ++k)
+	{
+		const double m = std::log1p(settings.compression * magnitudes[k]);
+		sum += jmax(0.0, m - previousMagnitudes[k]);
+		previousMagnitudes[k] = m;
+	}
+
+	flux.push_back(sum);
+
+	// keep the overlap for the next frame
+	std::copy(frame.begin() + hop, frame.end(), frame.begin());
+	framePosition = size - hop;
+}
+
+void OnsetDetector::finish()
+{
+	const int size = fft.getSize();
+
+	// zero pad until every sample has been the centre of some frame's hop
+	while (int64(flux.size()) * settings.hopSize < totalSamples)
+	{
+		std::fill(frame.begin() + framePosition, frame.end(), 0.0);
+		framePosition = size;
+		analyseFrame();
+	}
+
+	pickPeaks();
+}
+
+void OnsetDetector::pickPeaks()
+{
+	onsets.clear();
+
+	const int n = int(flux.size());
+	const double maxFlux = n > 0 ? *std::max_element(flux.begin(), flux.end()) : 0.0;
+
+	if (maxFlux <= 0)
+		return;
+
+	vector<double> normalised(flux.size());
+	for (size_t i = 0; i < flux.size(); ++i)
+		normalised[i] = flux[i] / maxFlux;
+
+	// prefix sums for the moving mean
+	vector<double> prefix(flux.size() + 1, 0.0);
+	for (size_t i = 0; i < flux.size(); ++i)
+		prefix[i + 1] = prefix[i] + normalised[i];
+
+	const int hop = settings.hopSize;
+	const int meanFrames = jmax(1, int(std::round(settings.meanWindowSeconds * sampleRate / hop)));
+	const int w = jmax(1, settings.peakWindow);
+	const int64 minimumGap = int64(settings.minimumGapSeconds * sampleRate);
+	int64 lastOnset = -minimumGap - 1;
+
+	for (int k = 0; k < n; ++k)
+	{
+		const double value = normalised[size_t(k)];
+
+		if (value <= 0)
+			continue;
+
+		bool isPeak = true;
+		for (int j = jmax(0, k - w); j <= jmin(n - 1, k + w) && isPeak; ++j)
+			isPeak = j == k || (j < k ? normalised[size_t(j)] < value : normalised[size_t(j)] <= value);
+
+		if (!isPeak)
+			continue;
+
+		const int first = jmax(0, k - meanFrames);
+		const int last = jmin(n, k + w + 1);
+		const double mean = (prefix[size_t(last)] - prefix[size_t(first)]) / (last - first);
+
+		if (value < mean + settings.threshold)
+			continue;
+
+		const int64 position = int64(k) * hop;
+
+		if (position - lastOnset < minimumGap || position >= totalSamples)
+			continue;
+
+		onsets.push_back(position);
+		lastOnset = position;
+	}
+}
+
+vector<double> OnsetDetector::getOnsetTimes() const
+{
+	vector<double> times;
+	times.reserve(onsets.size());
+
+	for (auto frame : onsets)
+		times.push_back(frame / sampleRate);
+
+	return times;
+}
+
+template <typename t> vector<int64> detectOnsets(MultichannelSpan<const t> audio, double sampleRate, const OnsetDetector::Settings & settings)
+{
+	OnsetDetector detector(sampleRate, settings);
+	detector.process(audio);
+	detector.finish();
+	return detector.getOnsets();
+}
+
+template void OnsetDetector::process(MultichannelSpan<const float>);
+template void OnsetDetector::process(MultichannelSpan<const double>);
+template vector<int64> detectOnsets(MultichannelSpan<const float>, double, const OnsetDetector::Settings &);
+template vector<int64> detectOnsets(MultichannelSpan<const double>, double, const OnsetDetector::Settings &);
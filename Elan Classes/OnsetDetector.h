@@ -0,0 +1,72 @@
+#pragma once
+
+/**
+* Spectral flux onset detector, fed with blocks of planar audio of any size.
+*
+* The channels are averaged to mono and cut into Hann windowed frames of 2^fftOrder samples,
+* hopSize apart, the first frame centred on sample 0. Each frame's magnitude spectrum is log
+* compressed and the flux is the sum of the bin increases over the previous frame.
+*
+* finish() normalises the flux curve to its maximum and picks the frames that are the largest
+* within +-peakWindow frames, exceed the mean of the surrounding meanWindowSeconds by threshold,
+* and come at least minimumGapSeconds after the previous onset. Onsets are reported at the
+* centre of their frame, so their resolution is one hop.
+*/
+class OnsetDetector
+{
+public:
+	struct Settings
+	{
+		int fftOrder = 10;                // 1024 samples
+		int hopSize = 256;
+		double compression = 100.0;       // log(1 + compression * |X|)
+		double threshold = 0.1;           // above the local mean, flux normalised to 0..1
+		double meanWindowSeconds = 0.1;
+		int peakWindow = 3;               // frames either side
+		double minimumGapSeconds = 0.03;
+
+		// changes with any of the values above, for onsets stored in an AnalysisSidecar
+		uint64 getHash() const;
+	};
+
+	OnsetDetector(double sampleRate, const Settings & settings);
+	explicit OnsetDetector(double sampleRate) : OnsetDetector(sampleRate, Settings()) {}
+
+	void reset();
+
+	template <typename t> void process(MultichannelSpan<const t> block);
+
+	// analyses what is left in the frame buffer and picks the onsets, call after the last block
+	void finish();
+
+	// frame positions of the onsets, valid after finish()
+	const vector<int64> & getOnsets() const { return onsets; }
+
+	// onsets in seconds from the start of the audio
+	vector<double> getOnsetTimes() const;
+
+	// one value per hop, valid after finish()
+	const vector<double> & getFlux() const { return flux; }
+
+protected:
+	double sampleRate;
+	Settings settings;
+	RealFFT fft;
+
+	vector<double> window;
+	vector<double> frame;       // fft size, mono samples collected for the next analysis
+	int framePosition = 0;      // samples in frame
+	vector<double> windowed;
+	vector<double> magnitudes;
+	vector<double> previousMagnitudes; // zero before the first frame, so a sound at sample 0 is an onset
+	int64 totalSamples = 0;
+
+	vector<double> flux;
+	vector<int64> onsets;
+
+	void analyseFrame();
+	void pickPeaks();
+};
+
+// Runs an OnsetDetector over a whole buffer, use getChannelRange() on the span to pick channels.
+template <typename t> vector<int64> detectOnsets(MultichannelSpan<const t> audio, double sampleRate, const OnsetDetector::Settings & settings = OnsetDetector::Settings());
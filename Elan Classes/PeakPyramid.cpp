@@ -0,0 +1,319 @@
+#include "ElanClassesHeader.h"
+
+// every level is 16 times coarser than the one below it
+const int PeakPyramid::levelSizes[] = { 64, 1024, 16384 };
+
+void PeakPyramid::Summary::add(const Summary & other)
+{
+	if (other.numSamples == 0)
+		return;
+
+	if (numSamples == 0)
+	{
+		*this = other;
+		return;
+	}
+
+	min = jmin(min, other.min);
+	max = jmax(max, other.max);
+	sumSquares += other.sumSquares;
+	numSamples += other.numSamples;
+}
+
+template <typename t> void PeakPyramid::build(MultichannelSpan<const t> audio)
+{
+	clear();
+
+	numChannels = audio.getNumChannels();
+	numFrames = audio.getNumFrames();
+
+	if (numChannels == 0 || numFrames == 0)
+	{
+		numFrames = 0;
+		return;
+	}
+
+	for (int l = 0; l < numLevels; ++l)
+	{
+		auto & level = levels[l];
+		level.blockSize = size_t(levelSizes[l]);
+		level.numBlocks = (numFrames + level.blockSize - 1) / level.blockSize;
+		level.min.resize(level.numBlocks * numChannels);
+		level.max.resize(level.numBlocks * numChannels);
+		level.sumSquares.resize(level.numBlocks * numChannels);
+	}
+
+	// finest level from the samples, each coarser level from the one below
+	auto & base = levels[0];
+
+	for (int ch = 0; ch < numChannels; ++ch)
+	{
+		const t * samples = audio.getChannelPointer(ch);
+
+		for (size_t b = 0; b < base.numBlocks; ++b)
+		{
+			const size_t start = b * base.blockSize;
+			const size_t end = jmin(start + base.blockSize, numFrames);
+
+			t lo = samples[start], hi = samples[start];
+			double sum = 0;
+
+			for (size_t i = start; i < end; ++i)
+			{
+				const t x = samples[i];
+				lo = x < lo ? x : lo;
+				hi = x > hi ? x : hi;
+				sum += double(x) * double(x);
+			}
+
+			const size_t index = ch * base.numBlocks + b;
+			base.min[index] = double(lo);
+			base.max[index] = double(hi);
+			base.sumSquares[index] = sum;
+		}
+	}
+
+	for (int l = 1; l < numLevels; ++l)
+	{
+		const auto & fine = levels[l - 1];
+		auto & coarse = levels[l];
+		const size_t ratio = coarse.blockSize / fine.blockSize;
+
+		for (int ch = 0; ch < numChannels; ++ch)
+		{
+			for (size_t b = 0; b < coarse.numBlocks; ++b)
+			{
+				const size_t first = ch * fine.numBlocks + b * ratio;
+				const size_t last = ch * fine.numBlocks + jmin((b + 1) * ratio, fine.numBlocks);
+
+				double lo = fine.min[first], hi = fine.max[first];
+				double sum = 0;
+
+				for (size_t i = first; i < last; ++i)
+				{
+					lo = jmin(lo, fine.min[i]);
+					hi = jmax(hi, fine.max[i]);
+					sum += fine.sumSquares[i];
+				}
+
+				const size_t index = ch * coarse.numBlocks + b;
+				coarse.min[index] = lo;
+				coarse.max[index] = hi;
+				coarse.sumSquares[index] = sum;
+			}
+		}
+	}
+}
+
+void PeakPyramid::clear()
+{
+	for (auto & level : levels)
+		level = Level();
+
+	numChannels = 0;
+	numFrames = 0;
+}
+
+void PeakPyramid::writeToStream(OutputStream & output) const
+{
+	output.writeInt(numChannels);
+	output.writeInt(numLevels);
+	output.writeInt64(int64(numFrames));
+
+	for (const auto & level : levels)
+	{
+		output.writeInt64(int64(level.blockSize));
+		output.writeInt64(int64(level.numBlocks));
+
+		for (const auto * values : { &level.min, &level.max, &level.sumSquares })
+			for (double v : *values)
+				output.writeDouble(v);
+	}
+}
+
+bool PeakPyramid::readFromMemory(const void * data, size_t size)
+{
+	clear();
+
+	MemoryInputStream input(data, size, false);
+
+	const int channels = input.readInt();
+	const int storedLevels = input.readInt();
+	const int64 frames = input.readInt64();
+
+	if (channels <= 0 || storedLevels != numLevels || frames <= 0)
+		return false;
+
+	for (int l = 0; l < numLevels; ++l)
+	{
+		auto & level = levels[l];
+		level.blockSize = size_t(input.readInt64());
+		level.numBlocks = size_t(input.readInt64());
+
+		const size_t count = level.numBlocks * size_t(channels);
+
+		if (level.blockSize != size_t(levelSizes[l])
+			|| level.numBlocks != (size_t(frames) + level.blockSize - 1) / level.blockSize
+			|| count > size_t(input.getNumBytesRemaining()) / (3 * sizeof(double)))
+		{
+			clear();
+			return false;
+		}
+
+		for (auto * values : { &level.min, &level.max, &level.sumSquares })
+		{
+			values->resize(count);
+			for (auto & v : *values)
+				v = input.readDouble();
+		}
+	}
+
+	numChannels = channels;
+	numFrames = size_t(frames);
+	return true;
+}
+
+size_t PeakPyramid::getSizeInBytes() const
+{
+	size_t bytes = 0;
+
+	for (const auto & level : levels)
+		bytes += level.min.size() * sizeof(double) * 3;
+
+	return bytes;
+}
+
+template <typename t> PeakPyramid::Summary PeakPyramid::getSummary(MultichannelSpan<const t> audio, int firstChannel, int numChannelsToRead, size_t startFrame, size_t length) const
+{
+	jassert(audio.getNumFrames() == numFrames && audio.getNumChannels() == numChannels); // pyramid built from other audio
+
+	Summary s;
+
+	const size_t end = startFrame + jmin(length, numFrames - jmin(startFrame, numFrames));
+	const int lastChannel = jmin(firstChannel + numChannelsToRead, numChannels);
+
+	if (startFrame >= end)
+		return s;
+
+	for (int ch = jmax(0, firstChannel); ch < lastChannel; ++ch)
+		accumulate(s, audio.getChannelPointer(ch), ch, startFrame, end, numLevels - 1);
+
+	return s;
+}
+
+template <typename t> void PeakPyramid::accumulate(Summary & s, const t * samples, int channel, size_t start, size_t end, int level) const
+{
+	if (start >= end)
+		return;
+
+	if (level < 0)
+	{
+		Summary raw;
+		raw.min = raw.max = samples[start];
+		raw.numSamples = end - start;
+
+		for (size_t i = start; i < end; ++i)
+		{
+			const double x = samples[i];
+			raw.min = jmin(raw.min, x);
+			raw.max = jmax(raw.max, x);
+			raw.sumSquares += x * x;
+		}
+
+		s.add(raw);
+		return;
+	}
+
+	const auto & l = levels[level];
+
+	// whole blocks inside the range, the last block may be short if the range runs to the end
+	const size_t firstBlock = (start + l.blockSize - 1) / l.blockSize;
+	const size_t lastBlock = end == numFrames ? l.numBlocks : end / l.blockSize;
+
+	if (firstBlock >= lastBlock)
+	{
+		accumulate(s, samples, channel, start, end, level - 1);
+		return;
+	}
+
+	accumulate(s, samples, channel, start, firstBlock * l.blockSize, level - 1);
+
+	for (size_t b = firstBlock; b < lastBlock; ++b)
+	{
+		const size_t index = channel * l.numBlocks + b;
+
+		Summary block;
+		block.min = l.min[index];
+		block.max = l.max[index];
+		block.sumSquares = l.sumSquares[index];
+		block.numSamples = jmin((b + 1) * l.blockSize, numFrames) - b * l.blockSize;
+
+		s.add(block);
+	}
+
+	accumulate(s, samples, channel, jmin(lastBlock * l.blockSize, end), end, level - 1);
+}
+
+template <typename t> double PeakPyramid::findPeak(MultichannelSpan<const t> audio, int firstChannel, int numChannelsToRead, size_t * frameOut, int * channelOut) const
+{
+	const double peak = getSummary(audio, firstChannel, numChannelsToRead, 0, numFrames).getPeak();
+	const int lastChannel = jmin(firstChannel + numChannelsToRead, numChannels);
+
+	auto blockPeak = [](const Level & l, size_t index) { return jmax(std::abs(l.min[index]), std::abs(l.max[index])); };
+
+	for (int ch = jmax(0, firstChannel); ch < lastChannel && peak > 0; ++ch)
+	{
+		// the first block at each level that holds the peak, its children are searched next
+		size_t first = 0, last = levels[numLevels - 1].numBlocks;
+		bool found = true;
+
+		for (int level = numLevels - 1; level >= 0 && found; --level)
+		{
+			const auto & l = levels[level];
+			found = false;
+
+			for (size_t b = first; b < last; ++b)
+			{
+				if (blockPeak(l, ch * l.numBlocks + b) == peak)
+				{
+					const size_t ratio = level > 0 ? l.blockSize / levels[level - 1].blockSize : l.blockSize;
+					const size_t numChildren = level > 0 ? levels[level - 1].numBlocks : numFrames;
+					first = b * ratio;
+					last = jmin(first + ratio, numChildren);
+					found = true;
+					break;
+				}
+			}
+		}
+
+		if (!found)
+			continue;
+
+		const t * samples = audio.getChannelPointer(ch);
+
+		for (size_t i = first; i < last; ++i)
+		{
+			if (std::abs(double(samples[i])) == peak)
+			{
+				if (frameOut)
+					*frameOut = i;
+				if (channelOut)
+					*channelOut = ch;
+				return samples[i];
+			}
+		}
+	}
+
+	if (frameOut)
+		*frameOut = 0;
+	if (channelOut)
+		*channelOut = jmax(0, firstChannel);
+	return 0;
+}
+
+template void PeakPyramid::build(MultichannelSpan<const double>);
+template void PeakPyramid::build(MultichannelSpan<const float>);
+template PeakPyramid::Summary PeakPyramid::getSummary(MultichannelSpan<const double>, int, int, size_t, size_t) const;
+template PeakPyramid::Summary PeakPyramid::getSummary(MultichannelSpan<const float>, int, int, size_t, size_t) const;
+template double PeakPyramid::findPeak(MultichannelSpan<const double>, int, int, size_t *, int *) const;
+template double PeakPyramid::findPeak(MultichannelSpan<const float>, int, int, size_t *, int *) const;
@@ -0,0 +1,84 @@
+#pragma once
+
+/**
+* Min, max and sum of squares of planar audio, summarised in blocks of 64, 1024 and 16384
+* frames per channel. Built once in a single pass, after which the peak, RMS or "is this range
+* silent" of any frame range costs a few hundred block lookups instead of a scan of every sample.
+*
+* A query covers the middle of the range with the coarsest whole blocks that fit and the ragged
+* ends with finer levels, down to at most 63 raw samples per end. The summary doesn't keep the
+* samples, so queries take the same audio the pyramid was built from.
+*
+* Memory use is 24 bytes per channel for every 64 frames, about 10% of a float buffer in total.
+*/
+class PeakPyramid
+{
+public:
+	struct Summary
+	{
+		double min = 0;
+		double max = 0;
+		double sumSquares = 0;
+		size_t numSamples = 0;
+
+		double getPeak() const { return jmax(std::abs(min), std::abs(max)); }
+		double getRMS() const { return numSamples > 0 ? std::sqrt(sumSquares / numSamples) : 0.0; }
+
+		void add(const Summary & other);
+	};
+
+	static const int levelSizes[];
+	static const int numLevels = 3;
+
+	template <typename t> void build(MultichannelSpan<const t> audio);
+	void clear();
+
+	bool isBuilt() const { return numFrames > 0; }
+
+	/** Little endian dump of all levels, for AnalysisSidecar. readFromMemory returns false on a malformed block. */
+	void writeToStream(OutputStream & output) const;
+	bool readFromMemory(const void * data, size_t size);
+	int getNumChannels() const { return numChannels; }
+	size_t getNumFrames() const { return numFrames; }
+	size_t getSizeInBytes() const;
+
+	/** Summary of frames [startFrame, startFrame + length) of channels [firstChannel, firstChannel + numChannels). */
+	template <typename t> Summary getSummary(MultichannelSpan<const t> audio, int firstChannel, int numChannels, size_t startFrame, size_t length) const;
+
+	template <typename t> double getPeak(MultichannelSpan<const t> audio, int firstChannel, int numChannels, size_t startFrame, size_t length) const
+	{
+		return getSummary(audio, firstChannel, numChannels, startFrame, length).getPeak();
+	}
+
+	template <typename t> double getRMS(MultichannelSpan<const t> audio, int firstChannel, int numChannels, size_t startFrame, size_t length) const
+	{
+		return getSummary(audio, firstChannel, numChannels, startFrame, length).getRMS();
+	}
+
+	/**
+	* Returns the sample with the largest magnitude in the given channels, and its frame and channel.
+	* Ties go to the lowest channel, then the lowest frame, like a channel by channel scan would.
+	* Walks down from the coarsest level through the blocks holding the peak only.
+	*/
+	template <typename t> double findPeak(MultichannelSpan<const t> audio, int firstChannel, int numChannels, size_t * frameOut = nullptr, int * channelOut = nullptr) const;
+
+	/** True if no sample in the range reaches minimumAmplitude. */
+	template <typename t> bool isSilent(MultichannelSpan<const t> audio, int firstChannel, int numChannels, size_t startFrame, size_t length, double minimumAmplitude) const
+	{
+		return getPeak(audio, firstChannel, numChannels, startFrame, length) < minimumAmplitude;
+	}
+
+protected:
+	struct Level
+	{
+		size_t blockSize = 0;
+		size_t numBlocks = 0;
+		vector<double> min, max, sumSquares; // [channel * numBlocks + block], double so peaks of double audio are exact
+	};
+
+	Level levels[numLevels];
+	int numChannels = 0;
+	size_t numFrames = 0;
+
+	template <typename t> void accumulate(Summary & s, const t * samples, int channel, size_t start, size_t end, int level) const;
+};
@@ -0,0 +1,227 @@
+#include "ElanClassesHeader.h"
+
+#if JUCE_INTEL && (defined (__SSE2__) || defined (_M_X64) || defined (__x86_64__) || (defined (_M_IX86_FP) && _M_IX86_FP >= 2))
+ #define SE_PEAKSEARCH_SIMD 1
+ #include <immintrin.h>
+ // GCC and clang only emit AVX2 instructions inside functions marked for it, MSVC always can
+ #if defined (__GNUC__) || defined (__clang__)
+  #define SE_AVX2_FUNCTION __attribute__((target("avx2")))
+ #else
+  #define SE_AVX2_FUNCTION
+ #endif
+#else
+ #define SE_PEAKSEARCH_SIMD 0
+#endif
+
+// samples per chunk, small enough that searching the winning chunk again stays in L1
+static const size_t peakSearchChunk = 4096;
+
+static std::atomic<bool> peakSearchUseSIMD{ true };
+
+static bool cpuHasAVX2()
+{
+	static const bool avx2 = SystemStats::hasAVX2();
+	return avx2;
+}
+
+bool PeakSearch::isUsingAVX2() { return SE_PEAKSEARCH_SIMD != 0 && cpuHasAVX2() && peakSearchUseSIMD; }
+
+void PeakSearch::setUseSIMD(bool v) { peakSearchUseSIMD = v; }
+
+template <typename t> static t maxMagnitudeScalar(const t * x, size_t n)
+{
+	// four independent maxima so the loop isn't one long dependency chain
+	t m0 = 0, m1 = 0, m2 = 0, m3 = 0;
+	size_t i = 0;
+
+	for (; i + 4 <= n; i += 4)
+	{
+		m0 = jmax(m0, std::abs(x[i]));
+		m1 = jmax(m1, std::abs(x[i + 1]));
+		m2 = jmax(m2, std::abs(x[i + 2]));
+		m3 = jmax(m3, std::abs(x[i + 3]));
+	}
+
+	for (; i < n; ++i)
+		m0 = jmax(m0, std::abs(x[i]));
+
+	return jmax(jmax(m0, m1), jmax(m2, m3));
+}
+
+#if SE_PEAKSEARCH_SIMD
+SE_AVX2_FUNCTION static float maxMagnitudeAVX2(const float * x, size_t n)
+{
+	const __m256 signMask = _mm256_set1_ps(-0.0f);
+	__m256 m0 = _mm256_setzero_ps(), m1 = _mm256_setzero_ps();
+	size_t i = 0;
+
+	for (; i + 16 <= n; i += 16)
+	{
+		m0 = _mm256_max_ps(m0, _mm256_andnot_ps(signMask, _mm256_loadu_ps(x + i)));
+		m1 = _mm256_max_ps(m1, _mm256_andnot_ps(signMask, _mm256_loadu_ps(x + i + 8)));
+	}
+
+	float lanes[8];
+	_mm256_storeu_ps(lanes, _mm256_max_ps(m0, m1));
+
+	float m = maxMagnitudeScalar(x + i, n - i);
+	for (float v : lanes)
+		m = jmax(m, v);
+
+	return m;
+}
+
+SE_AVX2_FUNCTION static double maxMagnitudeAVX2(const double * x, size_t n)
+{
+	const __m256d signMask = _mm256_set1_pd(-0.0);
+	__m256d m0 = _mm256_setzero_pd(), m1 = _mm256_setzero_pd();
+	size_t i = 0;
+
+	for (; i + 8 <= n; i += 8)
+	{
+		m0 = _mm256_max_pd(m0, _mm256_andnot_pd(signMask, _mm256_loadu_pd(x + i)));
+		m1 = _mm256_max_pd(m1, _mm256_andnot_pd(signMask, _mm256_loadu_pd(x + i + 4)));
+	}
+
+	double lanes[4];
+	_mm256_storeu_pd(lanes, _mm256_max_pd(m0, m1));
+
+	double m = maxMagnitudeScalar(x + i, n - i);
+	for (double v : lanes)
+		m = jmax(m, v);
+
+	return m;
+}
+#endif
+
+template <typename t> t PeakSearch::getMaxMagnitude(const t * samples, size_t numSamples)
+{
+   #if SE_PEAKSEARCH_SIMD
+	if (isUsingAVX2())
+		return maxMagnitudeAVX2(samples, numSamples);
+   #endif
+
+	return maxMagnitudeScalar(samples, numSamples);
+}
+
+template <typename t> PeakSearch::Result PeakSearch::findPeak(const t * samples, size_t numSamples)
+{
+	Result result;
+	t best = 0;
+	size_t bestChunk = numSamples;
+
+	for (size_t start = 0; start < numSamples; start += peakSearchChunk)
+	{
+		const t m = getMaxMagnitude(samples + start, jmin(peakSearchChunk, numSamples - start));
+
+		if (m > best)
+		{
+			best = m;
+			bestChunk = start;
+		}
+	}
+
+	for (size_t i = bestChunk; i < numSamples; ++i)
+	{
+		if (std::abs(samples[i]) == best)
+		{
+			result.value = samples[i];
+			result.frame = i;
+			break;
+		}
+	}
+
+	return result;
+}
+
+template <typename t> PeakSearch::Result PeakSearch::findPeak(MultichannelSpan<const t> audio, int firstChannel, int numChannels)
+{
+	Result result;
+	result.channel = jmax(0, firstChannel);
+
+	const int lastChannel = jmin(firstChannel + numChannels, audio.getNumChannels());
+
+	for (int ch = jmax(0, firstChannel); ch < lastChannel; ++ch)
+	{
+		const Result r = findPeak(audio.getChannelPointer(ch), audio.getNumFrames());
+
+		if (r.getMagnitude() > result.getMagnitude())
+		{
+			result = r;
+			result.channel = ch;
+		}
+	}
+
+	return result;
+}
+
+template float PeakSearch::getMaxMagnitude(const float *, size_t);
+template double PeakSearch::getMaxMagnitude(const double *, size_t);
+template PeakSearch::Result PeakSearch::findPeak(const float *, size_t);
+template PeakSearch::Result PeakSearch::findPeak(const double *, size_t);
+template PeakSearch::Result PeakSearch::findPeak(MultichannelSpan<const float>, int, int);
+template PeakSearch::Result PeakSearch::findPeak(MultichannelSpan<const double>, int, int);
+
+String benchmarkPeakSearch(size_t numBytes, int numChannels, int iterations)
+{
+	numChannels = jmax(1, numChannels);
+	const size_t numFrames = numBytes / sizeof(double) / size_t(numChannels);
+
+	PlanarBuffer<double> audio(numChannels, numFrames);
+	Random random;
+
+	for (int ch = 0; ch < numChannels; ++ch)
+		for (auto & v : audio[ch])
+			v = random.nextDouble() * 2.0 - 1.0;
+
+	MultichannelSpan<const double> view = audio.getView();
+	vector<const double *> channels;
+	for (int ch = 0; ch < numChannels; ++ch)
+		channels.push_back(audio.getReadPointer(ch));
+
+	auto secondsPerRun = [iterations](std::function<void()> func)
+	{
+		func(); // warm up, page in the buffer
+		const int64 start = Time::getHighResolutionTicks();
+		for (int i = 0; i < iterations; ++i)
+			func();
+		return Time::highResolutionTicksToSeconds(Time::getHighResolutionTicks() - start) / iterations;
+	};
+
+	size_t loopFrame = 0, kernelFrame = 0;
+
+	// the loop getPeakValue used: frame-major over take[ch][fr], branch on every sample
+	const double loopSeconds = secondsPerRun([&]()
+	{
+		double absPeak = 0;
+		for (size_t fr = 0; fr < numFrames; ++fr)
+			for (int ch = 0; ch < numChannels; ++ch)
+			{
+				const double a = std::abs(channels[ch][fr]);
+				if (a > absPeak)
+				{
+					absPeak = a;
+					loopFrame = fr;
+				}
+			}
+	});
+
+	PeakSearch::setUseSIMD(false);
+	const double scalarSeconds = secondsPerRun([&]() { kernelFrame = PeakSearch::findPeak(view, 0, numChannels).frame; });
+	PeakSearch::setUseSIMD(true);
+	const double simdSeconds = secondsPerRun([&]() { kernelFrame = PeakSearch::findPeak(view, 0, numChannels).frame; });
+
+	const double gigabytes = numFrames * numChannels * sizeof(double) / double(1 << 30);
+
+	String report;
+	report << "PeakSearch: " << numChannels << " channels, " << int64(numFrames) << " frames (" << String(gigabytes, 2) << " GB), AVX2 "
+		<< (PeakSearch::isUsingAVX2() ? "on" : "off") << "\n";
+	report << "frame-major loop: " << String(gigabytes / loopSeconds, 2) << " GB/s\n";
+	report << "PeakSearch scalar: " << String(gigabytes / scalarSeconds, 2) << " GB/s (" << String(loopSeconds / scalarSeconds, 2) << "x)\n";
+	report << "PeakSearch AVX2: " << String(gigabytes / simdSeconds, 2) << " GB/s (" << String(loopSeconds / simdSeconds, 2) << "x)\n";
+
+	if (numChannels == 1 && loopFrame != kernelFrame)
+		report << "frame mismatch!\n";
+
+	return report;
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+/**
+* Finds the sample with the largest magnitude in planar audio.
+*
+* Each channel is scanned front to back in 4096 sample chunks. The magnitude maximum of a chunk
+* is computed branch free, with AVX2 when the CPU has it and a scalar loop otherwise, and only
+* the chunk holding the peak is searched again for its index. Ties go to the lowest channel,
+* then the lowest frame, the same result as a channel by channel scan with a strict comparison.
+*/
+class PeakSearch
+{
+public:
+	struct Result
+	{
+		double value = 0;   // signed
+		size_t frame = 0;
+		int channel = 0;
+
+		double getMagnitude() const { return std::abs(value); }
+	};
+
+	template <typename t> static Result findPeak(MultichannelSpan<const t> audio, int firstChannel, int numChannels);
+	template <typename t> static Result findPeak(const t * samples, size_t numSamples);
+
+	// largest magnitude only, the inner kernel of findPeak
+	template <typename t> static t getMaxMagnitude(const t * samples, size_t numSamples);
+
+	static bool isUsingAVX2();
+
+	// forces the scalar kernel, for benchmarking and testing
+	static void setUseSIMD(bool v);
+};
+
+// Times PeakSearch against the frame-major per-sample loop AUDIOFUNCTION::getPeakValue used, on numBytes of double audio.
+juce::String benchmarkPeakSearch(size_t numBytes = size_t(1) << 30, int numChannels = 2, int iterations = 3);
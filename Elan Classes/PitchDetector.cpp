@@ -0,0 +1,224 @@
+#include "ElanClassesHeader.h"
+
+namespace
+{
+	int getPitchFrameSize(double sampleRate, double minimumFrequency)
+	{
+		// two periods of the lowest pitch
+		const int maximumLag = int(std::ceil(sampleRate / jmax(1.0, minimumFrequency)));
+		return 1 << RealFFT::getOrderForSize(2 * maximumLag);
+	}
+}
+
+PitchDetector::PitchDetector(double sampleRate, const Settings & settings)
+	: sampleRate(sampleRate), settings(settings),
+	frameSize(getPitchFrameSize(sampleRate, settings.minimumFrequency)),
+	fft(RealFFT::getOrderForSize(2 * frameSize)) // zero padded so the autocorrelation doesn't wrap around
+{
+	maximumLag = jmin(frameSize - 2, int(std::ceil(sampleRate / jmax(1.0, settings.minimumFrequency))));
+	minimumLag = jlimit(2, maximumLag, int(std::floor(sampleRate / jmax(1.0, settings.maximumFrequency))));
+
+	padded.resize(size_t(fft.getSize()));
+	spectrum.resize(size_t(fft.getNumBins()));
+	autocorrelation.resize(size_t(fft.getSize()));
+	nsdf.resize(size_t(maximumLag + 2));
+}
+
+PitchDetector::Result PitchDetector::detectFrame(const double * frame)
+{
+	std::copy(frame, frame + frameSize, padded.begin());
+	std::fill(padded.begin() + frameSize, padded.end(), 0.0);
+
+	fft.forward(padded.data(), spectrum.data());
+
+	for (auto & bin : spectrum)
+		bin = std::norm(bin);
+
+	fft.inverse(spectrum.data(), autocorrelation.data());
+
+	// m(tau) = sum of x[j]^2 + x[j + tau]^2 over the overlap, shrinks by two samples per lag
+	double m = 0;
+	for (int j = 0; j < frameSize; ++j)
+		m += 2.0 * frame[j] * frame[j];
+
+	if (m <= 1.e-20)
+		return {};
+
+	const int lastLag = maximumLag + 1;
+
+	for (int tau = 0; tau <= lastLag; ++tau)
+	{
+		nsdf[size_t(tau)] = m > 0 ? 2.0 * autocorrelation[size_t(tau)] / m : 0.0;
+		m -= frame[tau] * frame[tau] + frame[frameSize - 1 - tau] * frame[frameSize - 1 - tau];
+	}
+
+	// key maxima, the highest point of each positive lobe after the first negative zero crossing
+	vector<int> keyMaxima;
+	int tau = 1;
+
+	while (tau < lastLag && nsdf[size_t(tau)] > 0)
+		++tau;
+
+	int lobeMax = -1;
+
+	for (; tau < lastLag; ++tau)
+	{
+		const double value = nsdf[size_t(tau)];
+
+		if (value > 0)
+		{
+			if (lobeMax < 0 || value > nsdf[size_t(lobeMax)])
+				lobeMax = tau;
+		}
+		else if (lobeMax >= 0)
+		{
+			keyMaxima.push_back(lobeMax);
+			lobeMax = -1;
+		}
+	}
+
+	if (lobeMax >= 0)
+		keyMaxima.push_back(lobeMax);
+
+	double highest = 0;
+	for (int k : keyMaxima)
+		if (k >= minimumLag)
+			highest = jmax(highest, nsdf[size_t(k)]);
+
+	if (highest <= 0)
+		return {};
+
+	for (int k : keyMaxima)
+	{
+		if (k < minimumLag || nsdf[size_t(k)] < settings.clarityThreshold * highest)
+			continue;
+
+		const double a = nsdf[size_t(k - 1)];
+		const double b = nsdf[size_t(k)];
+		const double c = nsdf[size_t(k + 1)];
+		const double denominator = a - 2.0 * b + c;
+		const double delta = denominator != 0 ? jlimit(-0.5, 0.5, 0.5 * (a - c) / denominator) : 0.0;
+
+		Result r;
+		r.clarity = b - 0.25 * (a - c) * delta;
+
+		if (r.clarity >= settings.minimumClarity)
+			r.frequency = sampleRate / (k + delta);
+
+		return r;
+	}
+
+	return {};
+}
+
+template <typename t> PitchDetector::Result PitchDetector::detect(MultichannelSpan<const t> audio)
+{
+	const int numChannels = audio.getNumChannels();
+	const size_t totalFrames = audio.getNumFrames();
+
+	if (numChannels == 0 || totalFrames == 0)
+		return {};
+
+	size_t start, length;
+	findSteadyState(audio, sampleRate, settings.maximumSeconds, start, length);
+
+	// at least one whole frame, centred on the steady state if the audio allows it
+	if (length < size_t(frameSize))
+	{
+		const size_t centre = start + length / 2;
+		start = totalFrames > size_t(frameSize) ? jmin(totalFrames - size_t(frameSize), centre - jmin(centre, size_t(frameSize / 2))) : 0;
+		length = jmin(totalFrames - start, size_t(frameSize));
+	}
+
+	vector<double> frame(static_cast<size_t>(frameSize));
+	vector<Result> voiced;
+	const double gain = 1.0 / numChannels;
+	const size_t hop = size_t(frameSize / 2);
+
+	for (size_t position = start; position < start + length; position += hop)
+	{
+		const size_t available = jmin(size_t(frameSize), start + length - position);
+
+		// only the first frame may be short, when the whole audio is shorter than a frame
+		if (available < size_t(frameSize) && position != start)
+			break;
+
+		for (size_t i = 0; i < size_t(frameSize); ++i)
+		{
+			double mono = 0;
+
+			if (i < available)
+				for (int ch = 0; ch < numChannels; ++ch)
+					mono += audio.getChannelPointer(ch)[position + i];
+
+			frame[i] = mono * gain;
+		}
+
+		const auto r = detectFrame(frame.data());
+
+		if (r.isValid())
+			voiced.push_back(r);
+	}
+
+	if (voiced.empty())
+		return {};
+
+	auto middle = voiced.begin() + voiced.size() / 2;
+	std::nth_element(voiced.begin(), middle, voiced.end(), [](const Result & a, const Result & b) { return a.frequency < b.frequency; });
+
+	return *middle;
+}
+
+template <typename t> void PitchDetector::findSteadyState(MultichannelSpan<const t> audio, double sampleRate, double maximumSeconds, size_t & start, size_t & length)
+{
+	const int numChannels = audio.getNumChannels();
+	const size_t totalFrames = audio.getNumFrames();
+	const size_t blockFrames = jmax(size_t(1), size_t(sampleRate * 0.05));
+	const size_t numBlocks = totalFrames / blockFrames;
+
+	start = 0;
+	length = totalFrames;
+
+	if (numBlocks < 3 || numChannels == 0)
+		return;
+
+	// mean square of the channel average per block
+	vector<double> level(numBlocks, 0.0);
+
+	for (size_t b = 0; b < numBlocks; ++b)
+	{
+		double sum = 0;
+
+		for (size_t i = b * blockFrames; i < (b + 1) * blockFrames; ++i)
+		{
+			double mono = 0;
+			for (int ch = 0; ch < numChannels; ++ch)
+				mono += audio.getChannelPointer(ch)[i];
+
+			sum += mono * mono;
+		}
+
+		level[b] = sum / (double(blockFrames) * numChannels * numChannels);
+	}
+
+	const size_t loudest = size_t(std::max_element(level.begin(), level.end()) - level.begin());
+	const double floor = level[loudest] * 0.063; // -12 dB
+	const size_t maximumBlocks = jmax(size_t(1), size_t(maximumSeconds / 0.05));
+
+	size_t first = loudest + 1;
+	size_t last = first;
+
+	while (last < numBlocks && last - first < maximumBlocks && level[last] >= floor)
+		++last;
+
+	if (last > first)
+	{
+		start = first * blockFrames;
+		length = (last - first) * blockFrames;
+	}
+}
+
+template PitchDetector::Result PitchDetector::detect(MultichannelSpan<const float>);
+template PitchDetector::Result PitchDetector::detect(MultichannelSpan<const double>);
+template void PitchDetector::findSteadyState(MultichannelSpan<const float>, double, double, size_t &, size_t &);
+template void PitchDetector::findSteadyState(MultichannelSpan<const double>, double, double, size_t &, size_t &);
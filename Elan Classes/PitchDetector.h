@@ -0,0 +1,65 @@
+#pragma once
+
+/**
+* Monophonic pitch detection with the McLeod Pitch Method (MPM).
+*
+* A frame of the channel average is turned into the normalised square difference function
+* n(tau) = 2 r(tau) / m(tau), with the autocorrelation r computed through a zero padded
+* RealFFT, O(W log W) instead of O(W^2). The first key maximum above clarityThreshold times
+* the highest one is the period, refined with a parabola through its neighbours.
+*
+* detect() looks at the steady state only, see findSteadyState(), and reports the median of
+* the frames that were clear enough, so a slightly drifting or vibrato note still reads right.
+* An instance owns FFT buffers, give every thread its own.
+*/
+class PitchDetector
+{
+public:
+	struct Settings
+	{
+		double minimumFrequency = 30.0;
+		double maximumFrequency = 4000.0;
+		double clarityThreshold = 0.9;   // MPM k, relative to the highest key maximum
+		double minimumClarity = 0.5;     // frames below this are unvoiced and ignored
+		double maximumSeconds = 1.0;     // of steady state to analyse
+	};
+
+	struct Result
+	{
+		double frequency = 0;
+		double clarity = 0;
+
+		bool isValid() const { return frequency > 0; }
+		double getMidiNote() const { return isValid() ? 69.0 + 12.0 * std::log2(frequency / 440.0) : 0.0; }
+	};
+
+	PitchDetector(double sampleRate, const Settings & settings);
+	explicit PitchDetector(double sampleRate) : PitchDetector(sampleRate, Settings()) {}
+
+	// median pitch of the steady state of the audio, channels averaged
+	template <typename t> Result detect(MultichannelSpan<const t> audio);
+
+	// pitch of one frame of getFrameSize() mono samples
+	Result detectFrame(const double * frame);
+
+	int getFrameSize() const { return frameSize; }
+
+	/**
+	* Frames [start, start + length) after the attack: from 50 ms past the loudest 50 ms block
+	* while the level stays within 12 dB of it, at most maximumSeconds. Audio too short to have
+	* a steady state returns the whole range.
+	*/
+	template <typename t> static void findSteadyState(MultichannelSpan<const t> audio, double sampleRate, double maximumSeconds, size_t & start, size_t & length);
+
+protected:
+	double sampleRate;
+	Settings settings;
+	int frameSize;
+	int minimumLag, maximumLag;
+	RealFFT fft;
+
+	vector<double> padded;
+	vector<RealFFT::Complex> spectrum;
+	vector<double> autocorrelation;
+	vector<double> nsdf;
+};
@@ -0,0 +1,258 @@
+#pragma once
+
+#include <type_traits>
+#include <vector>
+
+#include "SampleConversion.h"
+
+using std::vector;
+
+/**
+* Non-owning view of a run of samples, usually one channel of a PlanarBuffer.
+* Indexing and iteration work like a vector, but the view never allocates.
+*/
+template <typename t> class SampleSpan
+{
+public:
+	using value_type = typename std::remove_const<t>::type;
+
+	SampleSpan() {}
+	SampleSpan(t * data, size_t size) : ptr(data), count(size) {}
+
+	// allows SampleSpan<double> to be passed where SampleSpan<const double> is expected
+	template <typename u, typename = typename std::enable_if<std::is_convertible<u*, t*>::value>::type>
+	SampleSpan(const SampleSpan<u> & other) : ptr(other.data()), count(other.size()) {}
+
+	SampleSpan(vector<value_type> & v) : ptr(v.data()), count(v.size()) {}
+
+	t & operator[](size_t i) const { return ptr[i]; }
+
+	t * data() const { return ptr; }
+	size_t size() const { return count; }
+	bool empty() const { return count == 0; }
+
+	t * begin() const { return ptr; }
+	t * end() const { return ptr + count; }
+	t & front() const { return ptr[0]; }
+	t & back() const { return ptr[count - 1]; }
+
+	// Returns a view of [offset, offset + length), clipped to the end of this view
+	SampleSpan subspan(size_t offset, size_t length) const
+	{
+		offset = offset < count ? offset : count;
+		length = length < count - offset ? length : count - offset;
+		return { ptr + offset, length };
+	}
+
+	// Makes an owning copy, use only when the data must outlive the buffer it views
+	vector<value_type> toVector() const { return { begin(), end() }; }
+
+protected:
+	t * ptr = nullptr;
+	size_t count = 0;
+};
+
+/**
+* Non-owning view of planar multichannel audio. Channel c starts at data + c * stride.
+* operator[] returns a SampleSpan, so code written for vector<vector<t>> keeps working.
+*/
+template <typename t> class MultichannelSpan
+{
+public:
+	MultichannelSpan() {}
+	MultichannelSpan(t * data, int numChannels, size_t numFrames, size_t channelStride)
+		: ptr(data), channels(numChannels), frames(numFrames), stride(channelStride)
+	{}
+
+	template <typename u, typename = typename std::enable_if<std::is_convertible<u*, t*>::value>::type>
+	MultichannelSpan(const MultichannelSpan<u> & other)
+		: ptr(other.getChannelPointer(0)), channels(other.getNumChannels()), frames(other.getNumFrames()), stride(other.getStride())
+	{}
+
+	SampleSpan<t> operator[](int channel) const { return { ptr + channel * stride, frames }; }
+
+	// number of channels, to mirror vector<vector<t>>::size()
+	int size() const { return channels; }
+	bool empty() const { return channels == 0 || frames == 0; }
+
+	int getNumChannels() const { return channels; }
+	size_t getNumFrames() const { return frames; }
+	size_t getStride() const { return stride; }
+	t * getChannelPointer(int channel) const { return ptr + channel * stride; }
+
+	// Returns a view of frames [offset, offset + length) of every channel
+	MultichannelSpan getFrameRange(size_t offset, size_t length) const
+	{
+		offset = offset < frames ? offset : frames;
+		length = length < frames - offset ? length : frames - offset;
+		return { ptr + offset, channels, length, stride };
+	}
+
+	// Returns a view of channels [first, first + num)
+	MultichannelSpan getChannelRange(int first, int num) const
+	{
+		return { ptr + first * stride, num, frames, stride };
+	}
+
+	class iterator
+	{
+	public:
+		iterator(const MultichannelSpan & s, int c) : span(s), channel(c) {}
+		SampleSpan<t> operator*() const { return span[channel]; }
+		iterator & operator++() { ++channel; return *this; }
+		bool operator!=(const iterator & rhs) const { return channel != rhs.channel; }
+
+	private:
+		const MultichannelSpan & span;
+		int channel;
+	};
+
+	iterator begin() const { return { *this, 0 }; }
+	iterator end() const { return { *this, channels }; }
+
+protected:
+	t * ptr = nullptr;
+	int channels = 0;
+	size_t frames = 0;
+	size_t stride = 0;
+};
+
+/**
+* Owning planar audio buffer. All channels live in one aligned heap block, each channel
+* starting on an alignment boundary so vector kernels can stream through it.
+*
+* The buffer is move-only. Use makeCopy() when a second copy is really needed.
+*/
+template <typename t> class PlanarBuffer
+{
+public:
+	static constexpr size_t alignment = 64; // cache line, also satisfies AVX
+
+	PlanarBuffer() {}
+	PlanarBuffer(int numChannels, size_t numFrames) { setSize(numChannels, numFrames); }
+
+	PlanarBuffer(PlanarBuffer && other) noexcept
+		: block(std::move(other.block)), base(other.base), channels(other.channels), frames(other.frames), stride(other.stride)
+	{
+		other.base = nullptr;
+		other.channels = 0;
+		other.frames = 0;
+		other.stride = 0;
+	}
+
+	PlanarBuffer & operator=(PlanarBuffer && other) noexcept
+	{
+		if (this != &other)
+		{
+			block = std::move(other.block);
+			base = other.base;
+			channels = other.channels;
+			frames = other.frames;
+			stride = other.stride;
+
+			other.base = nullptr;
+			other.channels = 0;
+			other.frames = 0;
+			other.stride = 0;
+		}
+		return *this;
+	}
+
+	PlanarBuffer(const PlanarBuffer &) = delete;
+	PlanarBuffer & operator=(const PlanarBuffer &) = delete;
+
+	PlanarBuffer makeCopy() const
+	{
+		PlanarBuffer copy(channels, frames);
+		if (base != nullptr)
+			memcpy(copy.base, base, sizeof(t) * stride * channels);
+		return copy;
+	}
+
+	// Reallocates the block, new samples are zeroed. Existing samples are kept if requested,
+	// otherwise the whole buffer is zeroed, also when the size doesn't change.
+	void setSize(int numChannels, size_t numFrames, bool keepExistingContent = false)
+	{
+		if (numChannels == channels && numFrames == frames)
+		{
+			if (!keepExistingContent && base != nullptr)
+				memset(base, 0, sizeof(t) * stride * size_t(channels));
+
+			return;
+		}
+
+		const size_t samplesPerAlignment = alignment / sizeof(t);
+		const size_t newStride = (numFrames + samplesPerAlignment - 1) / samplesPerAlignment * samplesPerAlignment;
+		const size_t bytes = sizeof(t) * newStride * size_t(numChannels);
+
+		juce::HeapBlock<char> newBlock;
+		t * newBase = nullptr;
+
+		if (bytes > 0)
+		{
+			newBlock.allocate(bytes + alignment, true);
+			newBase = reinterpret_cast<t*>((reinterpret_cast<uintptr_t>(newBlock.get()) + alignment - 1) & ~uintptr_t(alignment - 1));
+		}
+
+		if (keepExistingContent && base != nullptr)
+		{
+			const int chansToCopy = juce::jmin(channels, numChannels);
+			const size_t framesToCopy = juce::jmin(frames, numFrames);
+
+			for (int c = 0; c < chansToCopy; ++c)
+				memcpy(newBase + c * newStride, base + c * stride, sizeof(t) * framesToCopy);
+		}
+
+		block = std::move(newBlock);
+		base = newBase;
+		channels = numChannels;
+		frames = numFrames;
+		stride = newStride;
+	}
+
+	// Frees the block
+	void reset()
+	{
+		block.free();
+		base = nullptr;
+		channels = 0;
+		frames = 0;
+		stride = 0;
+	}
+
+	void fill(t value)
+	{
+		for (int c = 0; c < channels; ++c)
+			std::fill(getWritePointer(c), getWritePointer(c) + frames, value);
+	}
+
+	SampleSpan<t> operator[](int channel) { return { base + channel * stride, frames }; }
+	SampleSpan<const t> operator[](int channel) const { return { base + channel * stride, frames }; }
+
+	MultichannelSpan<t> getView() { return { base, channels, frames, stride }; }
+	MultichannelSpan<const t> getView() const { return { base, channels, frames, stride }; }
+
+	t * getWritePointer(int channel) { return base + channel * stride; }
+	const t * getReadPointer(int channel) const { return base + channel * stride; }
+
+	int getNumChannels() const { return channels; }
+	size_t getNumFrames() const { return frames; }
+	size_t getStride() const { return stride; }
+	size_t getSizeInBytes() const { return sizeof(t) * stride * size_t(channels); }
+	bool empty() const { return base == nullptr; }
+
+protected:
+	juce::HeapBlock<char> block;
+	t * base = nullptr;
+	int channels = 0;
+	size_t frames = 0;
+	size_t stride = 0;
+};
+
+// Deinterleaves into a freshly allocated planar buffer, one allocation regardless of channel count.
+template <typename t> PlanarBuffer<t> InterleavedToPlanar(const double * input, int channels, size_t frames)
+{
+	PlanarBuffer<t> buffer(channels, frames);
+	SampleConverter::deinterleave(input, channels, frames, buffer.getWritePointer(0), buffer.getStride());
+	return buffer;
+}
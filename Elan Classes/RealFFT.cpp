@@ -0,0 +1,120 @@
+#include "ElanClassesHeader.h"
+
+RealFFT::RealFFT(int order)
+{
+	jassert(order >= 1 && order < 30);
+
+	size = 1 << order;
+	half = size / 2;
+
+	const double pi = MathConstants<double>::pi;
+
+	bitReverse.resize(size_t(half));
+	for (int i = 0, bits = order - 1; i < half; ++i)
+	{
+		int r = 0;
+		for (int b = 0; b < bits; ++b)
+			r |= ((i >> b) & 1) << (bits - 1 - b);
+		bitReverse[size_t(i)] = r;
+	}
+
+	twiddles.resize(size_t(jmax(1, half / 2)));
+	for (size_t k = 0; k < twiddles.size(); ++k)
+		twiddles[k] = std::polar(1.0, -2.0 * pi * double(k) / double(half));
+
+	split.resize(size_t(half));
+	for (size_t k = 0; k < split.size(); ++k)
+		split[k] = std::polar(1.0, -2.0 * pi * double(k) / double(size));
+
+	scratch.resize(size_t(half));
+	bins.resize(size_t(half + 1));
+}
+
+int RealFFT::getOrderForSize(int minimumSize)
+{
+	int order = 1;
+	while ((1 << order) < minimumSize)
+		++order;
+	return order;
+}
+
+void RealFFT::transform(Complex * data, bool isInverse) const
+{
+	for (int i = 0; i < half; ++i)
+		if (i < bitReverse[size_t(i)])
+			std::swap(data[i], data[bitReverse[size_t(i)]]);
+
+	for (int length = 2; length <= half; length <<= 1)
+	{
+		const int step = half / length;
+		const int middle = length / 2;
+
+		for (int start = 0; start < half; start += length)
+		{
+			for (int j = 0; j < middle; ++j)
+			{
+				const Complex w = isInverse ? std::conj(twiddles[size_t(j * step)]) : twiddles[size_t(j * step)];
+				const Complex a = data[start + j];
+				const Complex b = data[start + j + middle] * w;
+
+				data[start + j] = a + b;
+				data[start + j + middle] = a - b;
+			}
+		}
+	}
+}
+
+void RealFFT::forward(const double * input, Complex * output)
+{
+	// even samples in the real part, odd samples in the imaginary part
+	for (int n = 0; n < half; ++n)
+		scratch[size_t(n)] = Complex(input[2 * n], input[2 * n + 1]);
+
+	transform(scratch.data(), false);
+
+	output[0] = Complex(scratch[0].real() + scratch[0].imag(), 0.0);
+	output[half] = Complex(scratch[0].real() - scratch[0].imag(), 0.0);
+
+	for (int k = 1; k < half; ++k)
+	{
+		const Complex a = scratch[size_t(k)];
+		const Complex b = std::conj(scratch[size_t(half - k)]);
+
+		const Complex even = (a + b) * 0.5;
+		const Complex odd = (a - b) * Complex(0.0, -0.5);
+
+		output[k] = even + split[size_t(k)] * odd;
+	}
+}
+
+void RealFFT::inverse(const Complex * input, double * output)
+{
+	for (int k = 0; k < half; ++k)
+	{
+		const Complex a = input[k];
+		const Complex b = std::conj(input[half - k]);
+
+		const Complex even = (a + b) * 0.5;
+		const Complex odd = (a - b) * 0.5 * std::conj(split[size_t(k)]);
+
+		scratch[size_t(k)] = even + Complex(0.0, 1.0) * odd;
+	}
+
+	transform(scratch.data(), true);
+
+	const double scale = 1.0 / half;
+
+	for (int n = 0; n < half; ++n)
+	{
+		output[2 * n] = scratch[size_t(n)].real() * scale;
+		output[2 * n + 1] = scratch[size_t(n)].imag() * scale;
+	}
+}
+
+void RealFFT::getMagnitudes(const double * input, double * output)
+{
+	forward(input, bins.data());
+
+	for (int k = 0; k <= half; ++k)
+		output[k] = std::abs(bins[size_t(k)]);
+}
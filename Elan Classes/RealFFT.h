@@ -0,0 +1,45 @@
+#pragma once
+
+#include <complex>
+
+/**
+* Radix-2 FFT of real signals, power of two sizes only.
+*
+* The N point real transform runs as an N/2 point complex transform plus one split pass, with
+* twiddles and the bit reversal table computed once in the constructor. forward() returns the
+* N/2 + 1 non-negative frequency bins, inverse() takes them back and scales by 1/N.
+*
+* An instance owns its scratch buffer, give every thread its own.
+*/
+class RealFFT
+{
+public:
+	using Complex = std::complex<double>;
+
+	explicit RealFFT(int order);
+
+	int getSize() const { return size; }
+	int getNumBins() const { return size / 2 + 1; }
+
+	// input has getSize() samples, output getNumBins() bins
+	void forward(const double * input, Complex * output);
+
+	// input has getNumBins() bins, output getSize() samples
+	void inverse(const Complex * input, double * output);
+
+	// |X[k]| of forward(input), output has getNumBins() values
+	void getMagnitudes(const double * input, double * output);
+
+	static int getOrderForSize(int minimumSize);
+
+protected:
+	int size;
+	int half;
+	vector<int> bitReverse;  // half entries
+	vector<Complex> twiddles; // exp(-2 pi i k / half), half / 2 entries
+	vector<Complex> split;    // exp(-2 pi i k / size), half entries
+	vector<Complex> scratch;
+	vector<Complex> bins;
+
+	void transform(Complex * data, bool isInverse) const;
+};
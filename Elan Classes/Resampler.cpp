@@ -0,0 +1,307 @@
+#include "ElanClassesHeader.h"
+
+namespace
+{
+	// zeroth order modified Bessel function of the first kind, for the Kaiser window
+	double besselI0(double x)
+	{
+		double sum = 1, term = 1;
+		const double q = x * x / 4.0;
+
+		for (int k = 1; k < 50 && term > sum * 1.e-17; ++k)
+		{
+			term *= q / (double(k) * k);
+			sum += term;
+		}
+
+		return sum;
+	}
+
+	int64 greatestCommonDivisor(int64 a, int64 b)
+	{
+		while (b != 0)
+		{
+			const int64 r = a % b;
+			a = b;
+			b = r;
+		}
+		return a;
+	}
+}
+
+Resampler::Resampler(int inputRate, int outputRate, int numChannels, Quality quality)
+	: numChannels(numChannels)
+{
+	jassert(inputRate > 0 && outputRate > 0);
+
+	inputRate = jmax(1, inputRate);
+	outputRate = jmax(1, outputRate);
+
+	const int64 g = greatestCommonDivisor(inputRate, outputRate);
+	up = outputRate / g;
+	down = inputRate / g;
+
+	const int baseTaps = quality == draft ? 16 : (quality == normal ? 32 : 64);
+	const double rolloff = quality == draft ? 0.85 : (quality == normal ? 0.9 : 0.95);
+	const double beta = quality == draft ? 5.65 : (quality == normal ? 8.96 : 12.26);
+
+	// when downsampling the kernel gets wider by the ratio, the cutoff lower
+	const double scale = jmin(1.0, double(outputRate) / inputRate);
+	const double cutoff = rolloff * 0.5 * scale; // cycles per input sample
+
+	numTaps = 2 * int(std::ceil(baseTaps / 2 / scale));
+	interpolatePhases = up > maxExactPhases;
+	numPhases = interpolatePhases ? maxExactPhases + 1 : int(up);
+
+	const double pi = MathConstants<double>::pi;
+	const int half = numTaps / 2;
+	const double windowNorm = besselI0(beta);
+
+	table.resize(size_t(numPhases) * size_t(numTaps));
+	blended.resize(size_t(numTaps));
+
+	for (int p = 0; p < numPhases; ++p)
+	{
+		const double fraction = interpolatePhases ? double(p) / maxExactPhases : double(p) / double(up);
+		double * row = table.data() + size_t(p) * size_t(numTaps);
+		double sum = 0;
+
+		for (int k = 0; k < numTaps; ++k)
+		{
+			// distance of input sample k from the output time
+			const double x = k - half + 1 - fraction;
+			const double r = jlimit(-1.0, 1.0, x / half);
+			const double window = besselI0(beta * std::sqrt(1.0 - r * r)) / windowNorm;
+			const double arg = 2.0 * cutoff * x;
+			const double sinc = arg == 0 ? 1.0 : std::sin(pi * arg) / (pi * arg);
+
+			row[k] = 2.0 * cutoff * sinc * window;
+			sum += row[k];
+		}
+
+		// unity gain at DC for every phase
+		for (int k = 0; k < numTaps; ++k)
+			row[k] /= sum;
+	}
+
+	reset();
+}
+
+void Resampler::reset()
+{
+	// the first output sits on the first input, the taps before it see silence
+	history.assign(size_t(numChannels), vector<double>(size_t(numTaps / 2 - 1), 0.0));
+	position = size_t(numTaps / 2 - 1);
+	phase = 0;
+	inputFrames = 0;
+	outputFrames = 0;
+}
+
+size_t Resampler::getOutputLength(size_t numFrames, int inputRate, int outputRate)
+{
+	const int64 g = greatestCommonDivisor(jmax(1, inputRate), jmax(1, outputRate));
+	const int64 l = outputRate / g;
+	const int64 m = inputRate / g;
+	return size_t((int64(numFrames) * l + m - 1) / m);
+}
+
+size_t Resampler::getMaxOutputFrames(size_t numInputFrames) const
+{
+	return size_t((int64(numInputFrames) + numTaps) * up / down) + 2;
+}
+
+template <typename t> size_t Resampler::produce(MultichannelSpan<t> output, int64 limit)
+{
+	jassert(output.getNumChannels() >= numChannels);
+
+	const int half = numTaps / 2;
+	const size_t available = history.empty() ? 0 : history[0].size();
+	const size_t capacity = output.getNumFrames();
+	size_t written = 0;
+
+	while (outputFrames < limit && written < capacity && position + size_t(half) < available)
+	{
+		const double * coefficients;
+
+		if (interpolatePhases)
+		{
+			const double row = double(phase) * maxExactPhases / double(up);
+			const int r0 = jmin(maxExactPhases - 1, int(row));
+			const double w = row - r0;
+			const double * a = table.data() + size_t(r0) * size_t(numTaps);
+			const double * b = a + numTaps;
+
+			for (int k = 0; k < numTaps; ++k)
+				blended[size_t(k)] = a[k] + (b[k] - a[k]) * w;
+
+			coefficients = blended.data();
+		}
+		else
+		{
+			coefficients = table.data() + size_t(phase) * size_t(numTaps);
+		}
+
+		const size_t start = position + 1 - size_t(half);
+
+		for (int ch = 0; ch < numChannels; ++ch)
+		{
+			const double * x = history[size_t(ch)].data() + start;
+			double sum = 0;
+
+			for (int k = 0; k < numTaps; ++k)
+				sum += coefficients[k] * x[k];
+
+			output.getChannelPointer(ch)[written] = t(sum);
+		}
+
+		++written;
+		++outputFrames;
+
+		phase += down;
+		position += size_t(phase / up);
+		phase %= up;
+	}
+
+	return written;
+}
+
+void Resampler::discardConsumed()
+{
+	const size_t keepFrom = position + 1 - size_t(numTaps / 2);
+
+	if (keepFrom == 0)
+		return;
+
+	for (auto & h : history)
+		h.erase(h.begin(), h.begin() + ptrdiff_t(jmin(keepFrom, h.size())));
+
+	position -= keepFrom;
+}
+
+template <typename t> size_t Resampler::process(MultichannelSpan<const t> input, MultichannelSpan<t> output)
+{
+	jassert(input.getNumChannels() >= numChannels);
+
+	for (int ch = 0; ch < numChannels; ++ch)
+	{
+		const t * x = input.getChannelPointer(ch);
+		history[size_t(ch)].insert(history[size_t(ch)].end(), x, x + input.getNumFrames());
+	}
+
+	inputFrames += int64(input.getNumFrames());
+
+	const int64 total = (inputFrames * up + down - 1) / down;
+	const size_t written = produce(output, total);
+
+	discardConsumed();
+	return written;
+}
+
+template <typename t> size_t Resampler::flush(MultichannelSpan<t> output)
+{
+	// silence after the end lets the last outputs see their full kernel
+	for (auto & h : history)
+		h.insert(h.end(), size_t(numTaps), 0.0);
+
+	const int64 total = (inputFrames * up + down - 1) / down;
+	const size_t written = produce(output, total);
+
+	discardConsumed();
+	return written;
+}
+
+template <typename t> PlanarBuffer<t> resampleBuffer(MultichannelSpan<const t> audio, int inputRate, int outputRate, Resampler::Quality quality)
+{
+	const int numChannels = audio.getNumChannels();
+	const size_t length = Resampler::getOutputLength(audio.getNumFrames(), inputRate, outputRate);
+
+	PlanarBuffer<t> output(numChannels, length);
+
+	if (numChannels == 0 || length == 0)
+		return output;
+
+	// nothing to convert, the filter would still soften the top octave
+	if (inputRate == outputRate)
+	{
+		for (int ch = 0; ch < numChannels; ++ch)
+			std::copy(audio[ch].begin(), audio[ch].end(), output[ch].begin());
+
+		return output;
+	}
+
+	Resampler resampler(inputRate, outputRate, numChannels, quality);
+
+	const size_t written = resampler.process(audio, output.getView());
+	resampler.flush(output.getView().getFrameRange(written, length - written));
+
+	return output;
+}
+
+String benchmarkResampler(int numChannels, double seconds, int inputRate, int outputRate)
+{
+	numChannels = jmax(1, numChannels);
+	const size_t numFrames = size_t(seconds * inputRate);
+
+	PlanarBuffer<float> audio(numChannels, numFrames);
+	Random random;
+
+	for (int ch = 0; ch < numChannels; ++ch)
+		for (auto & v : audio[ch])
+			v = random.nextFloat() * 2.0f - 1.0f;
+
+	MultichannelSpan<const float> input = audio.getView();
+
+	auto timeIt = [](std::function<void()> func)
+	{
+		const int64 start = Time::getHighResolutionTicks();
+		func();
+		return Time::highResolutionTicksToSeconds(Time::getHighResolutionTicks() - start);
+	};
+
+	const double inputSamples = double(numFrames) * numChannels;
+
+	String report;
+	report << "Resampler: " << inputRate << " -> " << outputRate << " Hz, " << numChannels << " channels, " << String(seconds, 1) << " s\n";
+
+	// the old convertSampleRate, rsResampler::transposeSinc with its default kernel on one channel at a time
+	{
+		const double factor = double(inputRate) / outputRate;
+		const int oldLength = int(std::ceil(numFrames / factor));
+		vector<float> out(size_t(oldLength));
+
+		const double elapsed = timeIt([&]()
+		{
+			for (int ch = 0; ch < numChannels; ++ch)
+				RAPT::rsResampler<float, float>::transposeSinc(audio.getReadPointer(ch), int(numFrames), out.data(), oldLength, float(factor));
+		});
+
+		report << "rsResampler::transposeSinc: " << String(inputSamples / elapsed / 1.e6, 1) << " M input samples/s\n";
+	}
+
+	const char * names[] = { "draft", "normal", "high" };
+
+	for (int q = 0; q < 3; ++q)
+	{
+		Resampler resampler(inputRate, outputRate, numChannels, Resampler::Quality(q));
+		PlanarBuffer<float> out(numChannels, resampler.getMaxOutputFrames(4096));
+
+		const double elapsed = timeIt([&]()
+		{
+			for (size_t start = 0; start < numFrames; start += 4096)
+				resampler.process(input.getFrameRange(start, 4096), out.getView());
+			resampler.flush(out.getView());
+		});
+
+		report << "polyphase " << names[q] << " (" << resampler.getNumTaps() << " taps, " << resampler.getNumPhases() << " phases"
+			<< (resampler.isExact() ? "" : ", interpolated") << "): " << String(inputSamples / elapsed / 1.e6, 1) << " M input samples/s\n";
+	}
+
+	return report;
+}
+
+template size_t Resampler::process(MultichannelSpan<const float>, MultichannelSpan<float>);
+template size_t Resampler::process(MultichannelSpan<const double>, MultichannelSpan<double>);
+template size_t Resampler::flush(MultichannelSpan<float>);
+template size_t Resampler::flush(MultichannelSpan<double>);
+template PlanarBuffer<float> resampleBuffer(MultichannelSpan<const float>, int, int, Resampler::Quality);
+template PlanarBuffer<double> resampleBuffer(MultichannelSpan<const double>, int, int, Resampler::Quality);
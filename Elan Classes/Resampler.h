@@ -0,0 +1,78 @@
+#pragma once
+
+/**
+* Streaming polyphase sample rate converter for planar multichannel audio.
+*
+* The ratio is reduced to L/M (44.1k -> 48k is 160/147). The Kaiser windowed sinc is tabulated
+* once for every one of the L phases, so producing a sample is one dot product per channel with
+* no trigonometry. Ratios with more than maxExactPhases phases use a table of maxExactPhases
+* phases and interpolate linearly between neighbouring phases. When downsampling the kernel is
+* stretched by the ratio so the cutoff follows the output Nyquist.
+*
+* The resampler keeps its history between calls, so blocks of any size can be fed, e.g. the
+* blocks of a TAKEBLOCKREADER. Output frame n is input time n * M / L, the first output frame
+* lines up with the first input frame. Call flush() after the last block to get the tail.
+*
+* Resampler resampler(44100, 48000, 2, Resampler::normal);
+* PlanarBuffer<double> out(2, resampler.getMaxOutputFrames(reader.getBlockSize()));
+* while (reader.readNextBlock())
+*	write(out.getView().getFrameRange(0, resampler.process(reader.getBlock(), out.getView())));
+* write(out.getView().getFrameRange(0, resampler.flush(out.getView())));
+*/
+class Resampler
+{
+public:
+	enum Quality
+	{
+		draft,  // 16 taps, cutoff at 0.85 of the lower Nyquist
+		normal, // 32 taps, 0.9
+		high    // 64 taps, 0.95
+	};
+
+	static constexpr int maxExactPhases = 4096;
+
+	Resampler(int inputRate, int outputRate, int numChannels, Quality quality = normal);
+
+	void reset();
+
+	// Upper bound of the frames one process() or flush() call writes for the given input
+	size_t getMaxOutputFrames(size_t inputFrames) const;
+
+	// Consumes all of input, writes what can be computed so far and returns the number of frames written.
+	// output must have the same channel count and at least getMaxOutputFrames(input frames) frames.
+	template <typename t> size_t process(MultichannelSpan<const t> input, MultichannelSpan<t> output);
+
+	// Writes the remaining frames, up to ceil(input frames * L / M) in total, and returns how many. reset() before reusing.
+	template <typename t> size_t flush(MultichannelSpan<t> output);
+
+	int getNumTaps() const { return numTaps; }
+	int getNumPhases() const { return numPhases; }
+	bool isExact() const { return !interpolatePhases; }
+
+	// output frames for a whole signal of numFrames input frames
+	static size_t getOutputLength(size_t numFrames, int inputRate, int outputRate);
+
+protected:
+	int numChannels;
+	int64 up, down;        // L and M
+	int numTaps;
+	int numPhases;         // rows in the table, L, or maxExactPhases + 1 when interpolating
+	bool interpolatePhases;
+	vector<double> table;  // [phase * numTaps + tap]
+	vector<double> blended; // row interpolated between two phases
+
+	vector<vector<double>> history; // per channel, starts with the samples the next output needs
+	size_t position = 0;            // index in history of the input sample at or before the next output
+	int64 phase = 0;                // 0..L-1, output time is position + phase / L
+	int64 inputFrames = 0;
+	int64 outputFrames = 0;
+
+	template <typename t> size_t produce(MultichannelSpan<t> output, int64 limit);
+	void discardConsumed();
+};
+
+// Converts a whole buffer, equal rates return a copy. Used by AUDIOPROCESS::convertSampleRate.
+template <typename t> PlanarBuffer<t> resampleBuffer(MultichannelSpan<const t> audio, int inputRate, int outputRate, Resampler::Quality quality = Resampler::normal);
+
+// Times Resampler against rsResampler::transposeSinc, which convertSampleRate used before, and returns a report.
+juce::String benchmarkResampler(int numChannels = 2, double seconds = 30.0, int inputRate = 44100, int outputRate = 48000);
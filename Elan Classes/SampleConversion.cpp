@@ -0,0 +1,605 @@
+#include <vector>
+#include <cstring>
+using std::vector;
+#include "SampleConversion.h"
+
+#if JUCE_INTEL && (defined (__SSE2__) || defined (_M_X64) || defined (__x86_64__) || (defined (_M_IX86_FP) && _M_IX86_FP >= 2))
+ #define SE_SAMPLECONVERSION_SSE2 1
+ #include <immintrin.h>
+ // GCC and clang only emit AVX instructions inside functions marked for it, MSVC always can
+ #if defined (__GNUC__) || defined (__clang__)
+  #define SE_AVX_FUNCTION __attribute__((target("avx")))
+ #else
+  #define SE_AVX_FUNCTION
+ #endif
+#else
+ #define SE_SAMPLECONVERSION_SSE2 0
+#endif
+
+// samples converted per pass when integer PCM has to go through a float buffer first
+static const size_t conversionScratchSamples = 4096;
+
+static bool cpuHasAVX()
+{
+	static const bool avx = SystemStats::hasAVX();
+	return avx;
+}
+
+bool SampleConverter::isUsingSSE2() { return SE_SAMPLECONVERSION_SSE2 != 0; }
+
+bool SampleConverter::isUsingAVX() { return SE_SAMPLECONVERSION_SSE2 != 0 && cpuHasAVX(); }
+
+// Pointers to each channel of a planar block, on the stack for the usual channel counts
+template <typename t> class StridedChannelPointers
+{
+public:
+	StridedChannelPointers(t * base, int numChannels, size_t stride)
+	{
+		if (numChannels > maxFixed)
+			heap.resize(numChannels);
+
+		t ** p = get();
+		for (int c = 0; c < numChannels; ++c)
+			p[c] = base + c * stride;
+	}
+
+	t ** get() { return heap.empty() ? fixed : heap.data(); }
+
+private:
+	static const int maxFixed = 16;
+	t * fixed[maxFixed];
+	vector<t *> heap;
+};
+
+//==============================================================================
+// scalar kernels
+
+template <typename In, typename Out> static void convertScalar(const In * src, Out * dst, size_t n)
+{
+	for (size_t i = 0; i < n; ++i)
+		dst[i] = Out(src[i]);
+}
+
+// frame by frame so the interleaved source is read once, front to back
+template <typename In, typename Out> static void deinterleaveScalar(const In * src, int numChannels, size_t numFrames, Out * const * dst)
+{
+	for (size_t fr = 0; fr < numFrames; ++fr, src += numChannels)
+		for (int ch = 0; ch < numChannels; ++ch)
+			dst[ch][fr] = Out(src[ch]);
+}
+
+template <typename In, typename Out> static void interleaveScalar(const In * const * src, int numChannels, size_t numFrames, Out * dst)
+{
+	for (size_t fr = 0; fr < numFrames; ++fr, dst += numChannels)
+		for (int ch = 0; ch < numChannels; ++ch)
+			dst[ch] = Out(src[ch][fr]);
+}
+
+template <typename Out> static void pcmToSamplesScalar(const uint8_t * src, SampleConverter::PcmFormat format, Out * dst, size_t n)
+{
+	switch (format)
+	{
+	case SampleConverter::pcm16:
+		for (size_t i = 0; i < n; ++i, src += 2)
+			dst[i] = Out(int16_t(ByteOrder::littleEndianShort(src)) * (1.0 / 32768.0));
+		break;
+	case SampleConverter::pcm24:
+		for (size_t i = 0; i < n; ++i, src += 3)
+			dst[i] = Out(ByteOrder::littleEndian24Bit(src) * (1.0 / 8388608.0));
+		break;
+	case SampleConverter::pcm32:
+		for (size_t i = 0; i < n; ++i, src += 4)
+			dst[i] = Out(int32_t(ByteOrder::littleEndianInt(src)) * (1.0 / 2147483648.0));
+		break;
+	default:
+		jassertfalse; // unknown format
+	}
+}
+
+template <typename In> static void samplesToPcmScalar(const In * src, uint8_t * dst, SampleConverter::PcmFormat format, size_t n)
+{
+	switch (format)
+	{
+	case SampleConverter::pcm16:
+		for (size_t i = 0; i < n; ++i, dst += 2)
+		{
+			const int v = jlimit(-32768, 32767, roundToInt(jlimit(-1.0, 1.0, double(src[i])) * 32768.0));
+			const uint16 le = ByteOrder::swapIfBigEndian(uint16(int16_t(v)));
+			memcpy(dst, &le, 2);
+		}
+		break;
+	case SampleConverter::pcm24:
+		for (size_t i = 0; i < n; ++i, dst += 3)
+			ByteOrder::littleEndian24BitToChars(jlimit(-8388608, 8388607, roundToInt(jlimit(-1.0, 1.0, double(src[i])) * 8388608.0)), dst);
+		break;
+	case SampleConverter::pcm32:
+		for (size_t i = 0; i < n; ++i, dst += 4)
+		{
+			// +1.0 would land one past INT32_MAX
+			const int v = roundToInt(jlimit(-2147483648.0, 2147483647.0, double(src[i]) * 2147483648.0));
+			const uint32 le = ByteOrder::swapIfBigEndian(uint32(v));
+			memcpy(dst, &le, 4);
+		}
+		break;
+	default:
+		jassertfalse; // unknown format
+	}
+}
+
+#if SE_SAMPLECONVERSION_SSE2
+//==============================================================================
+// SSE2 / AVX kernels. Single precision paths run through four floats at a time,
+// loading and storing doubles converts on the way in and out.
+
+static inline __m128 load4(const float * p) { return _mm_loadu_ps(p); }
+static inline __m128 load4(const double * p) { return _mm_movelh_ps(_mm_cvtpd_ps(_mm_loadu_pd(p)), _mm_cvtpd_ps(_mm_loadu_pd(p + 2))); }
+
+static inline void store4(float * p, __m128 v) { _mm_storeu_ps(p, v); }
+static inline void store4(double * p, __m128 v)
+{
+	_mm_storeu_pd(p, _mm_cvtps_pd(v));
+	_mm_storeu_pd(p + 2, _mm_cvtps_pd(_mm_movehl_ps(v, v)));
+}
+
+template <typename In, typename Out> static void convertSSE2(const In * src, Out * dst, size_t n)
+{
+	size_t i = 0;
+	for (; i + 4 <= n; i += 4)
+		store4(dst + i, load4(src + i));
+	convertScalar(src + i, dst + i, n - i);
+}
+
+SE_AVX_FUNCTION static void convertAVX(const double * src, float * dst, size_t n)
+{
+	size_t i = 0;
+	for (; i + 8 <= n; i += 8)
+	{
+		_mm_storeu_ps(dst + i, _mm256_cvtpd_ps(_mm256_loadu_pd(src + i)));
+		_mm_storeu_ps(dst + i + 4, _mm256_cvtpd_ps(_mm256_loadu_pd(src + i + 4)));
+	}
+	convertScalar(src + i, dst + i, n - i);
+}
+
+SE_AVX_FUNCTION static void convertAVX(const float * src, double * dst, size_t n)
+{
+	size_t i = 0;
+	for (; i + 8 <= n; i += 8)
+	{
+		_mm256_storeu_pd(dst + i, _mm256_cvtps_pd(_mm_loadu_ps(src + i)));
+		_mm256_storeu_pd(dst + i + 4, _mm256_cvtps_pd(_mm_loadu_ps(src + i + 4)));
+	}
+	convertScalar(src + i, dst + i, n - i);
+}
+
+template <typename In, typename Out> static void deinterleaveStereoSSE2(const In * src, size_t n, Out * left, Out * right)
+{
+	size_t i = 0;
+	for (; i + 4 <= n; i += 4)
+	{
+		const __m128 a = load4(src + 2 * i);     // l0 r0 l1 r1
+		const __m128 b = load4(src + 2 * i + 4); // l2 r2 l3 r3
+		store4(left + i, _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+		store4(right + i, _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+	}
+	for (; i < n; ++i)
+	{
+		left[i] = Out(src[2 * i]);
+		right[i] = Out(src[2 * i + 1]);
+	}
+}
+
+static void deinterleaveStereoSSE2(const double * src, size_t n, double * left, double * right)
+{
+	size_t i = 0;
+	for (; i + 2 <= n; i += 2)
+	{
+		const __m128d a = _mm_loadu_pd(src + 2 * i);     // l0 r0
+		const __m128d b = _mm_loadu_pd(src + 2 * i + 2); // l1 r1
+		_mm_storeu_pd(left + i, _mm_unpacklo_pd(a, b));
+		_mm_storeu_pd(right + i, _mm_unpackhi_pd(a, b));
+	}
+	for (; i < n; ++i)
+	{
+		left[i] = src[2 * i];
+		right[i] = src[2 * i + 1];
+	}
+}
+
+template <typename In, typename Out> static void interleaveStereoSSE2(const In * left, const In * right, size_t n, Out * dst)
+{
+	size_t i = 0;
+	for (; i + 4 <= n; i += 4)
+	{
+		const __m128 l = load4(left + i);
+		const __m128 r = load4(right + i);
+		store4(dst + 2 * i, _mm_unpacklo_ps(l, r));
+		store4(dst + 2 * i + 4, _mm_unpackhi_ps(l, r));
+	}
+	for (; i < n; ++i)
+	{
+		dst[2 * i] = Out(left[i]);
+		dst[2 * i + 1] = Out(right[i]);
+	}
+}
+
+static void interleaveStereoSSE2(const double * left, const double * right, size_t n, double * dst)
+{
+	size_t i = 0;
+	for (; i + 2 <= n; i += 2)
+	{
+		const __m128d l = _mm_loadu_pd(left + i);
+		const __m128d r = _mm_loadu_pd(right + i);
+		_mm_storeu_pd(dst + 2 * i, _mm_unpacklo_pd(l, r));
+		_mm_storeu_pd(dst + 2 * i + 2, _mm_unpackhi_pd(l, r));
+	}
+	for (; i < n; ++i)
+	{
+		dst[2 * i] = left[i];
+		dst[2 * i + 1] = right[i];
+	}
+}
+
+static void pcm16ToFloatSSE2(const uint8_t * src, float * dst, size_t n)
+{
+	const __m128 scale = _mm_set1_ps(1.0f / 32768.0f);
+
+	size_t i = 0;
+	for (; i + 8 <= n; i += 8)
+	{
+		const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + 2 * i));
+		// place each 16 bit value in the top half of a 32 bit lane, then shift down to sign extend
+		const __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+		const __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16);
+		_mm_storeu_ps(dst + i, _mm_mul_ps(_mm_cvtepi32_ps(lo), scale));
+		_mm_storeu_ps(dst + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), scale));
+	}
+	pcmToSamplesScalar(src + 2 * i, SampleConverter::pcm16, dst + i, n - i);
+}
+
+static void floatToPcm16SSE2(const float * src, uint8_t * dst, size_t n)
+{
+	const __m128 scale = _mm_set1_ps(32768.0f);
+	const __m128 lower = _mm_set1_ps(-1.0f);
+	const __m128 upper = _mm_set1_ps(1.0f);
+
+	size_t i = 0;
+	for (; i + 8 <= n; i += 8)
+	{
+		const __m128 a = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(src + i), lower), upper);
+		const __m128 b = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(src + i + 4), lower), upper);
+		// +1.0 becomes 32768, the saturating pack clips it to 32767
+		const __m128i packed = _mm_packs_epi32(_mm_cvtps_epi32(_mm_mul_ps(a, scale)), _mm_cvtps_epi32(_mm_mul_ps(b, scale)));
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(dst + 2 * i), packed);
+	}
+	samplesToPcmScalar(src + i, dst + 2 * i, SampleConverter::pcm16, n - i);
+}
+#endif
+
+//==============================================================================
+// per type dispatch
+
+static void convertSamples(const float * src, float * dst, size_t n)
+{
+	if (src != dst)
+		memcpy(dst, src, n * sizeof(float));
+}
+
+static void convertSamples(const double * src, double * dst, size_t n)
+{
+	if (src != dst)
+		memcpy(dst, src, n * sizeof(double));
+}
+
+template <typename In, typename Out> static void convertSamples(const In * src, Out * dst, size_t n)
+{
+#if SE_SAMPLECONVERSION_SSE2
+	if (cpuHasAVX())
+		convertAVX(src, dst, n);
+	else
+		convertSSE2(src, dst, n);
+#else
+	convertScalar(src, dst, n);
+#endif
+}
+
+static void pcmToSamples(const uint8_t * src, SampleConverter::PcmFormat format, float * dst, size_t n)
+{
+#if SE_SAMPLECONVERSION_SSE2
+	if (format == SampleConverter::pcm16)
+		return pcm16ToFloatSSE2(src, dst, n);
+#endif
+	pcmToSamplesScalar(src, format, dst, n);
+}
+
+static void pcmToSamples(const uint8_t * src, SampleConverter::PcmFormat format, double * dst, size_t n)
+{
+#if SE_SAMPLECONVERSION_SSE2
+	// 16 bit values are exact in float, so go through the vector path in chunks
+	if (format == SampleConverter::pcm16)
+	{
+		float scratch[conversionScratchSamples];
+
+		for (size_t done = 0; done < n; done += conversionScratchSamples)
+		{
+			const size_t num = jmin(conversionScratchSamples, n - done);
+			pcm16ToFloatSSE2(src + 2 * done, scratch, num);
+			convertSamples(scratch, dst + done, num);
+		}
+		return;
+	}
+#endif
+	pcmToSamplesScalar(src, format, dst, n);
+}
+
+static void samplesToPcm(const float * src, uint8_t * dst, SampleConverter::PcmFormat format, size_t n)
+{
+#if SE_SAMPLECONVERSION_SSE2
+	if (format == SampleConverter::pcm16)
+		return floatToPcm16SSE2(src, dst, n);
+#endif
+	samplesToPcmScalar(src, dst, format, n);
+}
+
+static void samplesToPcm(const double * src, uint8_t * dst, SampleConverter::PcmFormat format, size_t n)
+{
+#if SE_SAMPLECONVERSION_SSE2
+	if (format == SampleConverter::pcm16)
+	{
+		float scratch[conversionScratchSamples];
+
+		for (size_t done = 0; done < n; done += conversionScratchSamples)
+		{
+			const size_t num = jmin(conversionScratchSamples, n - done);
+			convertSamples(src + done, scratch, num);
+			floatToPcm16SSE2(scratch, dst + 2 * done, num);
+		}
+		return;
+	}
+#endif
+	samplesToPcmScalar(src, dst, format, n);
+}
+
+//==============================================================================
+
+template <typename In, typename Out> void SampleConverter::convert(const In * src, Out * dst, size_t numSamples)
+{
+	convertSamples(src, dst, numSamples);
+}
+
+template <typename In, typename Out> void SampleConverter::deinterleave(const In * src, int numChannels, size_t numFrames, Out * const * dst)
+{
+	if (numChannels == 1)
+		return convertSamples(src, dst[0], numFrames);
+
+#if SE_SAMPLECONVERSION_SSE2
+	if (numChannels == 2)
+		return deinterleaveStereoSSE2(src, numFrames, dst[0], dst[1]);
+#endif
+
+	deinterleaveScalar(src, numChannels, numFrames, dst);
+}
+
+template <typename In, typename Out> void SampleConverter::deinterleave(const In * src, int numChannels, size_t numFrames, Out * dst, size_t dstStride)
+{
+	StridedChannelPointers<Out> channels(dst, numChannels, dstStride);
+	deinterleave(src, numChannels, numFrames, channels.get());
+}
+
+template <typename In, typename Out> void SampleConverter::interleave(const In * const * src, int numChannels, size_t numFrames, Out * dst)
+{
+	if (numChannels == 1)
+		return convertSamples(src[0], dst, numFrames);
+
+#if SE_SAMPLECONVERSION_SSE2
+	if (numChannels == 2)
+		return interleaveStereoSSE2(src[0], src[1], numFrames, dst);
+#endif
+
+	interleaveScalar(src, numChannels, numFrames, dst);
+}
+
+template <typename Out> void SampleConverter::fromPcm(const void * src, PcmFormat format, Out * dst, size_t numSamples)
+{
+	pcmToSamples(static_cast<const uint8_t *>(src), format, dst, numSamples);
+}
+
+template <typename In> void SampleConverter::toPcm(const In * src, void * dst, PcmFormat format, size_t numSamples)
+{
+	samplesToPcm(src, static_cast<uint8_t *>(dst), format, numSamples);
+}
+
+template <typename Out> void SampleConverter::deinterleaveFromPcm(const void * src, PcmFormat format, int numChannels, size_t numFrames, Out * const * dst)
+{
+	if (numChannels == 1)
+		return fromPcm(src, format, dst[0], numFrames);
+
+	// convert a cache sized run of frames to interleaved floats, then split that into channels
+	const uint8_t * bytes = static_cast<const uint8_t *>(src);
+	const size_t bytesPerFrame = size_t(numChannels) * getBytesPerSample(format);
+	const size_t chunkFrames = jmax<size_t>(1, conversionScratchSamples / numChannels);
+
+	vector<Out> scratch(chunkFrames * numChannels);
+	vector<Out *> offsetDst(numChannels);
+
+	for (size_t done = 0; done < numFrames; done += chunkFrames)
+	{
+		const size_t num = jmin(chunkFrames, numFrames - done);
+
+		pcmToSamples(bytes + done * bytesPerFrame, format, scratch.data(), num * numChannels);
+
+		for (int c = 0; c < numChannels; ++c)
+			offsetDst[c] = dst[c] + done;
+
+		deinterleave(scratch.data(), numChannels, num, offsetDst.data());
+	}
+}
+
+template <typename In> void SampleConverter::interleaveToPcm(const In * const * src, int numChannels, size_t numFrames, void * dst, PcmFormat format)
+{
+	if (numChannels == 1)
+		return toPcm(src[0], dst, format, numFrames);
+
+	uint8_t * bytes = static_cast<uint8_t *>(dst);
+	const size_t bytesPerFrame = size_t(numChannels) * getBytesPerSample(format);
+	const size_t chunkFrames = jmax<size_t>(1, conversionScratchSamples / numChannels);
+
+	vector<In> scratch(chunkFrames * numChannels);
+	vector<const In *> offsetSrc(numChannels);
+
+	for (size_t done = 0; done < numFrames; done += chunkFrames)
+	{
+		const size_t num = jmin(chunkFrames, numFrames - done);
+
+		for (int c = 0; c < numChannels; ++c)
+			offsetSrc[c] = src[c] + done;
+
+		interleave(offsetSrc.data(), numChannels, num, scratch.data());
+		samplesToPcm(scratch.data(), bytes + done * bytesPerFrame, format, num * numChannels);
+	}
+}
+
+template void SampleConverter::convert(const float *, float *, size_t);
+template void SampleConverter::convert(const float *, double *, size_t);
+template void SampleConverter::convert(const double *, float *, size_t);
+template void SampleConverter::convert(const double *, double *, size_t);
+
+template void SampleConverter::deinterleave(const float *, int, size_t, float * const *);
+template void SampleConverter::deinterleave(const float *, int, size_t, double * const *);
+template void SampleConverter::deinterleave(const double *, int, size_t, float * const *);
+template void SampleConverter::deinterleave(const double *, int, size_t, double * const *);
+
+template void SampleConverter::deinterleave(const float *, int, size_t, float *, size_t);
+template void SampleConverter::deinterleave(const float *, int, size_t, double *, size_t);
+template void SampleConverter::deinterleave(const double *, int, size_t, float *, size_t);
+template void SampleConverter::deinterleave(const double *, int, size_t, double *, size_t);
+
+template void SampleConverter::interleave(const float * const *, int, size_t, float *);
+template void SampleConverter::interleave(const float * const *, int, size_t, double *);
+template void SampleConverter::interleave(const double * const *, int, size_t, float *);
+template void SampleConverter::interleave(const double * const *, int, size_t, double *);
+
+template void SampleConverter::fromPcm(const void *, PcmFormat, float *, size_t);
+template void SampleConverter::fromPcm(const void *, PcmFormat, double *, size_t);
+template void SampleConverter::toPcm(const float *, void *, PcmFormat, size_t);
+template void SampleConverter::toPcm(const double *, void *, PcmFormat, size_t);
+
+template void SampleConverter::deinterleaveFromPcm(const void *, PcmFormat, int, size_t, float * const *);
+template void SampleConverter::deinterleaveFromPcm(const void *, PcmFormat, int, size_t, double * const *);
+template void SampleConverter::interleaveToPcm(const float * const *, int, size_t, void *, PcmFormat);
+template void SampleConverter::interleaveToPcm(const double * const *, int, size_t, void *, PcmFormat);
+
+//==============================================================================
+
+String benchmarkSampleConversion(int numChannels, size_t numFrames, int iterations)
+{
+	const size_t numSamples = size_t(numChannels) * numFrames;
+
+	Random random;
+	vector<double> interleaved(numSamples);
+	for (auto & v : interleaved)
+		v = random.nextDouble() * 2.0 - 1.0;
+
+	vector<int16_t> interleavedPcm(numSamples);
+	PlanarBuffer<float> planarFloat(numChannels, numFrames);
+	PlanarBuffer<double> planarDouble(numChannels, numFrames);
+	StridedChannelPointers<float> floatChannels(planarFloat.getWritePointer(0), numChannels, planarFloat.getStride());
+	StridedChannelPointers<double> doubleChannels(planarDouble.getWritePointer(0), numChannels, planarDouble.getStride());
+	float ** f = floatChannels.get();
+	double ** d = doubleChannels.get();
+
+	auto secondsPerRun = [iterations](std::function<void()> func)
+	{
+		func(); // warm up caches and page in the buffers
+		const int64 start = Time::getHighResolutionTicks();
+		for (int i = 0; i < iterations; ++i)
+			func();
+		return Time::highResolutionTicksToSeconds(Time::getHighResolutionTicks() - start) / iterations;
+	};
+
+	String report;
+	report << "SampleConverter: " << numChannels << " channels, " << int64(numFrames) << " frames, SSE2 "
+		<< (SampleConverter::isUsingSSE2() ? "on" : "off") << ", AVX " << (SampleConverter::isUsingAVX() ? "on" : "off") << "\n";
+
+	auto addLine = [&](const String & name, std::function<void()> loop, std::function<void()> converter)
+	{
+		const double loopSeconds = secondsPerRun(loop);
+		const double converterSeconds = secondsPerRun(converter);
+		const double megaSamples = numSamples / 1.0e6;
+
+		report << name << ": loop " << String(megaSamples / loopSeconds, 1) << " Msamples/s, SampleConverter "
+			<< String(megaSamples / converterSeconds, 1) << " Msamples/s (" << String(loopSeconds / converterSeconds, 2) << "x)\n";
+	};
+
+	addLine("InterleavedToMultichannel",
+		[&]()
+	{
+		// the push_back version this replaced
+		vector<vector<double>> data(numChannels);
+		for (auto & c : data)
+			c.reserve(numFrames);
+		for (int ch = 0; ch < numChannels; ++ch)
+			for (size_t x = 0, y = ch; x < numFrames; ++x, y += numChannels)
+				data[ch].push_back(interleaved[y]);
+	},
+		[&]() { InterleavedToMultichannel(interleaved.data(), numChannels, int(numFrames)); });
+
+	addLine("deinterleave double -> float (PluginChain::render input)",
+		[&]()
+	{
+		for (int i = 0; i < numChannels; ++i)
+			for (size_t j = 0; j < numFrames; ++j)
+				f[i][j] = float(interleaved[j * numChannels + i]);
+	},
+		[&]() { SampleConverter::deinterleave(interleaved.data(), numChannels, numFrames, f); });
+
+	addLine("deinterleave double -> double (take loading)",
+		[&]()
+	{
+		for (int i = 0; i < numChannels; ++i)
+			for (size_t j = 0; j < numFrames; ++j)
+				d[i][j] = interleaved[j * numChannels + i];
+	},
+		[&]() { SampleConverter::deinterleave(interleaved.data(), numChannels, numFrames, d); });
+
+	addLine("planar float -> double (PluginChain::render output)",
+		[&]()
+	{
+		for (int i = 0; i < numChannels; ++i)
+			for (size_t j = 0; j < numFrames; ++j)
+				d[i][j] = f[i][j];
+	},
+		[&]()
+	{
+		for (int i = 0; i < numChannels; ++i)
+			SampleConverter::convert(f[i], d[i], numFrames);
+	});
+
+	addLine("interleave double -> double",
+		[&]()
+	{
+		for (int i = 0; i < numChannels; ++i)
+			for (size_t j = 0; j < numFrames; ++j)
+				interleaved[j * numChannels + i] = d[i][j];
+	},
+		[&]() { SampleConverter::interleave(d, numChannels, numFrames, interleaved.data()); });
+
+	addLine("interleave float -> int16",
+		[&]()
+	{
+		for (int i = 0; i < numChannels; ++i)
+			for (size_t j = 0; j < numFrames; ++j)
+				interleavedPcm[j * numChannels + i] = int16_t(jlimit(-32768, 32767, roundToInt(jlimit(-1.0f, 1.0f, f[i][j]) * 32768.0f)));
+	},
+		[&]() { SampleConverter::interleaveToPcm(f, numChannels, numFrames, interleavedPcm.data(), SampleConverter::pcm16); });
+
+	addLine("deinterleave int16 -> float",
+		[&]()
+	{
+		for (int i = 0; i < numChannels; ++i)
+			for (size_t j = 0; j < numFrames; ++j)
+				f[i][j] = interleavedPcm[j * numChannels + i] / 32768.0f;
+	},
+		[&]() { SampleConverter::deinterleaveFromPcm(interleavedPcm.data(), SampleConverter::pcm16, numChannels, numFrames, f); });
+
+	return report;
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+* Converts blocks of samples between interleaved and planar layouts, float and double,
+* and the little endian 16, 24 and 32 bit integer PCM stored in WAV files.
+*
+* float <-> double, mono and stereo (de)interleaving and 16 bit PCM use SSE2, plain
+* float <-> double conversion also uses AVX when the CPU supports it. Everything else, and
+* every non Intel build, uses scalar loops. The instruction set is picked at runtime.
+*
+* Integer PCM is scaled the same way JUCE does it: reading divides by 2^(bits-1), writing
+* multiplies by 2^(bits-1), rounds and clips.
+*/
+class SampleConverter
+{
+public:
+	enum PcmFormat
+	{
+		pcm16 = 2,
+		pcm24 = 3,
+		pcm32 = 4
+	}; // value is the number of bytes per sample
+
+	static int getBytesPerSample(PcmFormat format) { return int(format); }
+
+	// dst[i] = src[i], for float/double in either direction
+	template <typename In, typename Out> static void convert(const In * src, Out * dst, size_t numSamples);
+
+	// interleaved src -> one pointer per channel
+	template <typename In, typename Out> static void deinterleave(const In * src, int numChannels, size_t numFrames, Out * const * dst);
+
+	// interleaved src -> planar dst where channel c starts at dst + c * dstStride, the layout of PlanarBuffer
+	template <typename In, typename Out> static void deinterleave(const In * src, int numChannels, size_t numFrames, Out * dst, size_t dstStride);
+
+	// one pointer per channel -> interleaved dst
+	template <typename In, typename Out> static void interleave(const In * const * src, int numChannels, size_t numFrames, Out * dst);
+
+	// contiguous integer PCM <-> float/double, src/dst point at raw little endian bytes
+	template <typename Out> static void fromPcm(const void * src, PcmFormat format, Out * dst, size_t numSamples);
+	template <typename In> static void toPcm(const In * src, void * dst, PcmFormat format, size_t numSamples);
+
+	// interleaved integer PCM <-> one pointer per channel
+	template <typename Out> static void deinterleaveFromPcm(const void * src, PcmFormat format, int numChannels, size_t numFrames, Out * const * dst);
+	template <typename In> static void interleaveToPcm(const In * const * src, int numChannels, size_t numFrames, void * dst, PcmFormat format);
+
+	static bool isUsingSSE2();
+	static bool isUsingAVX();
+};
+
+// Times SampleConverter against the per-sample loops it replaced and returns a report, one line per case.
+juce::String benchmarkSampleConversion(int numChannels = 2, size_t numFrames = 1 << 20, int iterations = 20);
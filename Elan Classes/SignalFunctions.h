@@ -1,3 +1,62 @@
 #pragma once
 
-vector<vector<double>> InterleavedToMultichannel(double* input, int channels, int frames);
\ No newline at end of file
+vector<vector<double>> InterleavedToMultichannel(double* input, int channels, int frames);
+
+/*
+Root mean square over the most recent windowSize samples, kept up to date with a running
+sum of squares so each new sample costs O(1) no matter how long the window is.
+*/
+class SlidingWindowRMS
+{
+public:
+	SlidingWindowRMS(int windowSize = 1) { setWindowSize(windowSize); }
+
+	void setWindowSize(int v)
+	{
+		squares.assign(size_t(jmax(1, v)), 0.0);
+		reset();
+	}
+
+	void reset()
+	{
+		std::fill(squares.begin(), squares.end(), 0.0);
+		sum = 0;
+		index = 0;
+		filled = 0;
+	}
+
+	// adds a sample and returns the RMS of the current window
+	double process(double x)
+	{
+		const double sq = x * x;
+		sum += sq - squares[index];
+		squares[index] = sq;
+
+		if (++index == squares.size())
+		{
+			index = 0;
+
+			// re-sum once per window so rounding errors in the running sum cannot build up
+			sum = 0;
+			for (double v : squares)
+				sum += v;
+		}
+
+		if (filled < squares.size())
+			++filled;
+
+		return getRMS();
+	}
+
+	// RMS of the samples seen so far if the window is not yet full
+	double getRMS() const { return filled > 0 ? sqrt(jmax(0.0, sum) / filled) : 0.0; }
+
+	bool isWindowFull() const { return filled == squares.size(); }
+	int getWindowSize() const { return int(squares.size()); }
+
+protected:
+	vector<double> squares;
+	double sum = 0;
+	size_t index = 0;
+	size_t filled = 0;
+};
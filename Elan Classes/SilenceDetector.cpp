@@ -0,0 +1,115 @@
+#include "ElanClassesHeader.h"
+
+SilenceDetector::SilenceDetector(double sampleRate, double threshold, double holdSeconds, double minimumLengthSeconds)
+	: sampleRate(sampleRate), threshold(threshold)
+{
+	jassert(sampleRate > 0);
+
+	holdFrames = int64(jmax(0.0, holdSeconds) * sampleRate);
+	minimumLengthFrames = int64(jmax(0.0, minimumLengthSeconds) * sampleRate);
+}
+
+void SilenceDetector::reset()
+{
+	segments.clear();
+	position = 0;
+	isOpen = false;
+	openStart = 0;
+	lastLoudFrame = 0;
+}
+
+template <typename t> void SilenceDetector::process(MultichannelSpan<const t> block)
+{
+	const int numChannels = block.getNumChannels();
+	const size_t numFrames = block.getNumFrames();
+	const t limit = t(threshold);
+
+	for (size_t chunkStart = 0; chunkStart < numFrames && !isDone(); chunkStart += chunkSize)
+	{
+		const size_t chunkFrames = jmin(size_t(chunkSize), numFrames - chunkStart);
+		const int64 chunkPosition = position + int64(chunkStart);
+
+		t chunkMax = 0;
+		for (int ch = 0; ch < numChannels; ++ch)
+			chunkMax = jmax(chunkMax, PeakSearch::getMaxMagnitude(block.getChannelPointer(ch) + chunkStart, chunkFrames));
+
+		if (chunkMax < limit)
+		{
+			// nothing loud in here, only the hold of an open segment can run out
+			if (isOpen && chunkPosition + int64(chunkFrames) - 1 - lastLoudFrame > holdFrames)
+				closeSegment();
+
+			continue;
+		}
+
+		for (size_t i = 0; i < chunkFrames && !isDone(); ++i)
+		{
+			const int64 frame = chunkPosition + int64(i);
+
+			bool isLoud = false;
+			for (int ch = 0; ch < numChannels && !isLoud; ++ch)
+				isLoud = std::abs(block.getChannelPointer(ch)[chunkStart + i]) >= limit;
+
+			if (isLoud)
+			{
+				if (!isOpen)
+				{
+					isOpen = true;
+					openStart = frame;
+				}
+
+				lastLoudFrame = frame;
+			}
+			else if (isOpen && frame - lastLoudFrame > holdFrames)
+			{
+				closeSegment();
+			}
+		}
+	}
+
+	position += int64(numFrames);
+}
+
+void SilenceDetector::finish()
+{
+	if (isOpen && !isDone())
+		closeSegment();
+
+	isOpen = false;
+}
+
+void SilenceDetector::closeSegment()
+{
+	Segment s;
+	s.start = openStart;
+	s.end = lastLoudFrame + 1;
+
+	if (s.getLength() >= minimumLengthFrames)
+		segments.push_back(s);
+
+	isOpen = false;
+}
+
+vector<RANGE> SilenceDetector::getRanges(double offsetSeconds) const
+{
+	vector<RANGE> ranges;
+	ranges.reserve(segments.size());
+
+	for (const auto & s : segments)
+		ranges.emplace_back(offsetSeconds + s.start / sampleRate, offsetSeconds + s.end / sampleRate);
+
+	return ranges;
+}
+
+template <typename t> vector<SilenceDetector::Segment> findNonSilentSegments(MultichannelSpan<const t> audio, double sampleRate, double threshold, double holdSeconds, double minimumLengthSeconds)
+{
+	SilenceDetector gate(sampleRate, threshold, holdSeconds, minimumLengthSeconds);
+	gate.process(audio);
+	gate.finish();
+	return gate.getSegments();
+}
+
+template void SilenceDetector::process(MultichannelSpan<const float>);
+template void SilenceDetector::process(MultichannelSpan<const double>);
+template vector<SilenceDetector::Segment> findNonSilentSegments(MultichannelSpan<const float>, double, double, double, double);
+template vector<SilenceDetector::Segment> findNonSilentSegments(MultichannelSpan<const double>, double, double, double, double);
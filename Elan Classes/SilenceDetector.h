@@ -0,0 +1,74 @@
+#pragma once
+
+/**
+* Streaming gate that finds the non-silent segments of planar audio, block by block.
+*
+* A frame is loud when any channel reaches the threshold in magnitude. A segment starts at
+* the first loud frame and ends after the last loud frame once the signal has stayed below
+* the threshold for longer than the hold time, so short dips inside a sound don't cut it in
+* two. Segments shorter than the minimum length are dropped.
+*
+* Audio is scanned in chunks of chunkSize frames. A chunk whose vectorised magnitude maximum
+* stays below the threshold is skipped as a whole, only chunks that reach it are walked frame
+* by frame. With setMaxSegments() the detector reports isDone() as soon as enough segments
+* were found, so a caller that only wants the first sound can stop reading early.
+*
+* SilenceDetector gate(sampleRate, Decibels::decibelsToGain(-60.0), 0.1, 0.05);
+* while (reader.readNextBlock())
+*	gate.process(reader.getBlock());
+* gate.finish();
+* auto ranges = gate.getRanges();
+*/
+class SilenceDetector
+{
+public:
+	// frames, end is exclusive
+	struct Segment
+	{
+		int64 start = 0;
+		int64 end = 0;
+
+		int64 getLength() const { return end - start; }
+	};
+
+	static constexpr int chunkSize = 256;
+
+	SilenceDetector(double sampleRate, double threshold, double holdSeconds = 0.1, double minimumLengthSeconds = 0.0);
+
+	void reset();
+
+	// stop once n segments were found, 0 for no limit
+	void setMaxSegments(size_t n) { maxSegments = n; }
+
+	template <typename t> void process(MultichannelSpan<const t> block);
+
+	// closes a segment still open at the end of the audio, call after the last block
+	void finish();
+
+	bool isDone() const { return maxSegments > 0 && segments.size() >= maxSegments; }
+
+	const vector<Segment> & getSegments() const { return segments; }
+
+	// segments in seconds, offsetSeconds is added to every range, e.g. the item position for project time
+	vector<RANGE> getRanges(double offsetSeconds = 0) const;
+
+	int64 getPosition() const { return position; }
+
+protected:
+	double sampleRate;
+	double threshold;
+	int64 holdFrames;
+	int64 minimumLengthFrames;
+	size_t maxSegments = 0;
+
+	vector<Segment> segments;
+	int64 position = 0;     // frames processed so far
+	bool isOpen = false;
+	int64 openStart = 0;
+	int64 lastLoudFrame = 0;
+
+	void closeSegment();
+};
+
+// Runs a SilenceDetector over a whole buffer, use getChannelRange() on the span to pick channels.
+template <typename t> vector<SilenceDetector::Segment> findNonSilentSegments(MultichannelSpan<const t> audio, double sampleRate, double threshold, double holdSeconds = 0.1, double minimumLengthSeconds = 0.0);
@@ -0,0 +1,481 @@
+#include "Audio.h"
+
+// labels are usually plain ASCII, but older tools write the system code page
+static String readChunkString(InputStream & input, int64 numBytes)
+{
+	MemoryBlock data;
+	input.readIntoMemoryBlock(data, (ssize_t) numBytes);
+
+	const char * text = static_cast<const char *>(data.getData());
+	size_t length = 0;
+
+	while (length < data.getSize() && text[length] != 0)
+		++length;
+
+	if (CharPointer_UTF8::isValidString(text, int(length)))
+		return String::fromUTF8(text, int(length));
+
+	String latin1;
+	for (size_t i = 0; i < length; ++i)
+		latin1 += juce_wchar(uint8(text[i]));
+
+	return latin1;
+}
+
+static void writeChunkHeader(OutputStream & output, const char * name, size_t size)
+{
+	output.writeInt(int(WavMetadata::chunkName(name)));
+	output.writeInt(int(uint32(size)));
+}
+
+static size_t getChunkStringSize(const String & text)
+{
+	return text.isEmpty() ? 0 : text.getNumBytesAsUTF8() + 1;
+}
+
+static void writeChunkString(OutputStream & output, const String & text)
+{
+	if (text.isEmpty())
+		return;
+
+	output.write(text.toRawUTF8(), text.getNumBytesAsUTF8());
+	output.writeByte(0);
+}
+
+// RIFF chunks start on even offsets
+static void padToEven(MemoryOutputStream & output)
+{
+	if (output.getDataSize() & 1)
+		output.writeByte(0);
+}
+
+bool WavMetadata::read(const File & file)
+{
+	FileInputStream input(file);
+
+	if (input.failedToOpen())
+	{
+		clear();
+		return false;
+	}
+
+	return read(input);
+}
+
+bool WavMetadata::read(InputStream & input)
+{
+	clear();
+
+	const int64 streamLength = input.getTotalLength();
+	const uint32 riffType = uint32(input.readInt());
+	const uint32 riffSize = uint32(input.readInt());
+
+	if ((riffType != chunkName("RIFF") && riffType != chunkName("RF64")) || uint32(input.readInt()) != chunkName("WAVE"))
+		return false;
+
+	format.isRF64 = riffType == chunkName("RF64");
+
+	// the RIFF size of an RF64 file lives in the ds64 chunk, only trust the stream there
+	int64 end = format.isRF64 ? streamLength : int64(riffSize) + 8;
+	if (streamLength >= 0)
+		end = jmin(end, streamLength);
+
+	int64 ds64DataSize = -1;
+	bool foundFormat = false;
+
+	while (input.getPosition() + 8 <= end)
+	{
+		const int64 chunkStart = input.getPosition();
+		const uint32 id = uint32(input.readInt());
+		int64 size = uint32(input.readInt());
+		const int64 bodyStart = chunkStart + 8;
+
+		ChunkInfo chunk;
+		chunk.id = id;
+		chunk.offset = chunkStart;
+
+		if (id == chunkName("ds64") && size >= 16)
+		{
+			format.ds64Offset = chunkStart;
+			input.readInt64(); // RIFF size
+			ds64DataSize = input.readInt64();
+		}
+		else if (id == chunkName("fmt ") && size >= 16)
+		{
+			format.formatTag = uint16(input.readShort());
+			format.numChannels = uint16(input.readShort());
+			format.sampleRate = uint32(input.readInt());
+			input.readInt(); // bytes per second
+			format.blockAlign = uint16(input.readShort());
+			format.bitsPerSample = uint16(input.readShort());
+			foundFormat = true;
+		}
+		else if (id == chunkName("data"))
+		{
+			if (format.isRF64 && ds64DataSize >= 0)
+				size = ds64DataSize;
+
+			format.dataOffset = bodyStart;
+			format.dataSize = jmin(size, end - bodyStart);
+		}
+		else if (id == chunkName("cue "))
+		{
+			readCueChunk(input, size);
+		}
+		else if (id == chunkName("LIST") && size >= 4)
+		{
+			chunk.listType = uint32(input.readInt());
+
+			if (chunk.listType == chunkName("adtl"))
+				readAdtlChunk(input, size - 4);
+		}
+		else if (id == chunkName("smpl"))
+		{
+			readSmplChunk(input, size);
+		}
+
+		chunk.size = size;
+		chunkList.push_back(chunk);
+
+		if (!input.setPosition(bodyStart + size + (size & 1)))
+			break;
+	}
+
+	updateIndex();
+
+	return foundFormat;
+}
+
+void WavMetadata::readCueChunk(InputStream & input, int64 size)
+{
+	if (size < 4)
+		return;
+
+	const int64 numCues = jmin<int64>(uint32(input.readInt()), (size - 4) / 24);
+
+	cues.resize(size_t(numCues));
+
+	for (auto & cue : cues)
+	{
+		cue.identifier = uint32(input.readInt());
+		cue.order = uint32(input.readInt());
+		cue.chunkId = uint32(input.readInt());
+		cue.chunkStart = uint32(input.readInt());
+		cue.blockStart = uint32(input.readInt());
+		cue.sampleOffset = uint32(input.readInt());
+	}
+}
+
+void WavMetadata::readAdtlChunk(InputStream & input, int64 size)
+{
+	const int64 end = input.getPosition() + size;
+
+	while (input.getPosition() + 8 <= end)
+	{
+		const int64 chunkStart = input.getPosition();
+		const uint32 id = uint32(input.readInt());
+		const int64 length = uint32(input.readInt());
+
+		if ((id == chunkName("labl") || id == chunkName("note")) && length >= 4)
+		{
+			Label label;
+			label.identifier = uint32(input.readInt());
+			label.text = readChunkString(input, length - 4);
+
+			(id == chunkName("labl") ? labels : notes).push_back(label);
+		}
+		else if (id == chunkName("ltxt") && length >= 20)
+		{
+			LabelledText ltxt;
+			ltxt.identifier = uint32(input.readInt());
+			ltxt.sampleLength = uint32(input.readInt());
+			ltxt.purpose = uint32(input.readInt());
+			ltxt.country = uint16(input.readShort());
+			ltxt.language = uint16(input.readShort());
+			ltxt.dialect = uint16(input.readShort());
+			ltxt.codePage = uint16(input.readShort());
+			ltxt.text = readChunkString(input, length - 20);
+
+			labelledTexts.push_back(ltxt);
+		}
+
+		if (!input.setPosition(chunkStart + 8 + length + (length & 1)))
+			break;
+	}
+}
+
+void WavMetadata::readSmplChunk(InputStream & input, int64 size)
+{
+	if (size < 36)
+		return;
+
+	hasSampler = true;
+
+	sampler.manufacturer = uint32(input.readInt());
+	sampler.product = uint32(input.readInt());
+	sampler.samplePeriod = uint32(input.readInt());
+	sampler.midiUnityNote = uint32(input.readInt());
+	sampler.midiPitchFraction = uint32(input.readInt());
+	sampler.smpteFormat = uint32(input.readInt());
+	sampler.smpteOffset = uint32(input.readInt());
+
+	const uint32 numLoops = uint32(input.readInt());
+	const uint32 samplerDataSize = uint32(input.readInt());
+	const int64 loopsToRead = jmin<int64>(numLoops, (size - 36) / 24);
+
+	sampler.loops.resize(size_t(loopsToRead));
+
+	for (auto & loop : sampler.loops)
+	{
+		loop.identifier = uint32(input.readInt());
+		loop.type = uint32(input.readInt());
+		loop.start = uint32(input.readInt());
+		loop.end = uint32(input.readInt());
+		loop.fraction = uint32(input.readInt());
+		loop.playCount = uint32(input.readInt());
+	}
+
+	const int64 remaining = size - 36 - loopsToRead * 24;
+
+	if (samplerDataSize > 0 && remaining > 0)
+		input.readIntoMemoryBlock(sampler.samplerData, (ssize_t) jmin<int64>(samplerDataSize, remaining));
+}
+
+void WavMetadata::clear()
+{
+	format = Format();
+	chunkList.clear();
+	cues.clear();
+	labels.clear();
+	notes.clear();
+	labelledTexts.clear();
+	sampler = Sampler();
+	hasSampler = false;
+	updateIndex();
+}
+
+void WavMetadata::updateIndex()
+{
+	cueIndex.clear();
+	labelIndex.clear();
+	noteIndex.clear();
+	labelledTextIndex.clear();
+
+	// the first entry wins if an identifier is used twice
+	for (size_t i = 0; i < cues.size(); ++i)
+		cueIndex.emplace(cues[i].identifier, i);
+	for (size_t i = 0; i < labels.size(); ++i)
+		labelIndex.emplace(labels[i].identifier, i);
+	for (size_t i = 0; i < notes.size(); ++i)
+		noteIndex.emplace(notes[i].identifier, i);
+	for (size_t i = 0; i < labelledTexts.size(); ++i)
+		labelledTextIndex.emplace(labelledTexts[i].identifier, i);
+}
+
+const WavMetadata::Cue * WavMetadata::getCue(uint32 identifier) const
+{
+	auto it = cueIndex.find(identifier);
+	return it != cueIndex.end() ? &cues[it->second] : nullptr;
+}
+
+const WavMetadata::LabelledText * WavMetadata::getLabelledText(uint32 identifier) const
+{
+	auto it = labelledTextIndex.find(identifier);
+	return it != labelledTextIndex.end() ? &labelledTexts[it->second] : nullptr;
+}
+
+String WavMetadata::getLabel(uint32 identifier) const
+{
+	auto it = labelIndex.find(identifier);
+	return it != labelIndex.end() ? labels[it->second].text : String();
+}
+
+String WavMetadata::getNote(uint32 identifier) const
+{
+	auto it = noteIndex.find(identifier);
+	return it != noteIndex.end() ? notes[it->second].text : String();
+}
+
+MemoryBlock WavMetadata::createCueChunk() const
+{
+	if (cues.empty())
+		return {};
+
+	MemoryOutputStream output;
+	writeChunkHeader(output, "cue ", 4 + cues.size() * 24);
+	output.writeInt(int(cues.size()));
+
+	for (const auto & cue : cues)
+	{
+		output.writeInt(int(cue.identifier));
+		output.writeInt(int(cue.order));
+		output.writeInt(int(cue.chunkId));
+		output.writeInt(int(cue.chunkStart));
+		output.writeInt(int(cue.blockStart));
+		output.writeInt(int(cue.sampleOffset));
+	}
+
+	return output.getMemoryBlock();
+}
+
+MemoryBlock WavMetadata::createAdtlChunk() const
+{
+	if (labels.empty() && notes.empty() && labelledTexts.empty())
+		return {};
+
+	MemoryOutputStream body;
+	body.writeInt(int(chunkName("adtl")));
+
+	auto writeLabels = [&body](const vector<Label> & list, const char * name)
+	{
+		for (const auto & label : list)
+		{
+			writeChunkHeader(body, name, 4 + getChunkStringSize(label.text));
+			body.writeInt(int(label.identifier));
+			writeChunkString(body, label.text);
+			padToEven(body);
+		}
+	};
+
+	writeLabels(labels, "labl");
+	writeLabels(notes, "note");
+
+	for (const auto & ltxt : labelledTexts)
+	{
+		writeChunkHeader(body, "ltxt", 20 + getChunkStringSize(ltxt.text));
+		body.writeInt(int(ltxt.identifier));
+		body.writeInt(int(ltxt.sampleLength));
+		body.writeInt(int(ltxt.purpose));
+		body.writeShort(short(ltxt.country));
+		body.writeShort(short(ltxt.language));
+		body.writeShort(short(ltxt.dialect));
+		body.writeShort(short(ltxt.codePage));
+		writeChunkString(body, ltxt.text);
+		padToEven(body);
+	}
+
+	MemoryOutputStream output;
+	writeChunkHeader(output, "LIST", body.getDataSize());
+	output.write(body.getData(), body.getDataSize());
+
+	return output.getMemoryBlock();
+}
+
+MemoryBlock WavMetadata::createSmplChunk() const
+{
+	if (!hasSampler)
+		return {};
+
+	MemoryOutputStream output;
+	writeChunkHeader(output, "smpl", 36 + sampler.loops.size() * 24 + sampler.samplerData.getSize());
+
+	output.writeInt(int(sampler.manufacturer));
+	output.writeInt(int(sampler.product));
+	output.writeInt(int(sampler.samplePeriod));
+	output.writeInt(int(sampler.midiUnityNote));
+	output.writeInt(int(sampler.midiPitchFraction));
+	output.writeInt(int(sampler.smpteFormat));
+	output.writeInt(int(sampler.smpteOffset));
+	output.writeInt(int(sampler.loops.size()));
+	output.writeInt(int(sampler.samplerData.getSize()));
+
+	for (const auto & loop : sampler.loops)
+	{
+		output.writeInt(int(loop.identifier));
+		output.writeInt(int(loop.type));
+		output.writeInt(int(loop.start));
+		output.writeInt(int(loop.end));
+		output.writeInt(int(loop.fraction));
+		output.writeInt(int(loop.playCount));
+	}
+
+	output.write(sampler.samplerData.getData(), sampler.samplerData.getSize());
+	padToEven(output);
+
+	return output.getMemoryBlock();
+}
+
+MemoryBlock WavMetadata::createChunks() const
+{
+	MemoryBlock chunks;
+
+	for (const auto & chunk : { createCueChunk(), createAdtlChunk(), createSmplChunk() })
+		chunks.append(chunk.getData(), chunk.getSize());
+
+	return chunks;
+}
+
+bool WavMetadata::ChunkInfo::isReplaceable() const
+{
+	return id == chunkName("cue ") || id == chunkName("smpl") || id == chunkName("JUNK")
+		|| (id == chunkName("LIST") && listType == chunkName("adtl"));
+}
+
+bool WavMetadata::patchFile(const File & file) const
+{
+	WavMetadata layout;
+
+	if (!layout.read(file) || layout.format.dataOffset == 0)
+		return false;
+
+	const int64 fileSize = file.getSize();
+
+	// the new chunks go after the last chunk that has to be kept
+	int64 tailStart = 12;
+	for (const auto & chunk : layout.chunkList)
+		if (!chunk.isReplaceable())
+			tailStart = chunk.getEnd();
+
+	const bool needsPad = (tailStart & 1) != 0;
+	tailStart += needsPad ? 1 : 0;
+
+	// a chunk size running past the end, e.g. an unfinished recording, can't be trusted
+	if (tailStart > fileSize + 1 || layout.format.dataOffset + layout.format.dataSize > fileSize)
+		return false;
+
+	const MemoryBlock chunks = createChunks();
+	const int64 newFileSize = tailStart + int64(chunks.getSize());
+	const int64 riffSize = newFileSize - 8;
+
+	if (layout.format.isRF64 ? layout.format.ds64Offset < 0 : riffSize > 0xffffffffLL)
+		return false;
+
+	FileOutputStream output(file);
+
+	if (output.failedToOpen())
+		return false;
+
+	for (const auto & chunk : layout.chunkList)
+	{
+		if (chunk.offset < tailStart && chunk.isReplaceable() && chunk.id != chunkName("JUNK"))
+		{
+			output.setPosition(chunk.offset);
+			output.writeInt(int(chunkName("JUNK")));
+		}
+	}
+
+	output.setPosition(needsPad ? tailStart - 1 : tailStart);
+
+	if (needsPad)
+		output.writeByte(0);
+
+	output.write(chunks.getData(), chunks.getSize());
+
+	if (newFileSize < fileSize)
+		output.truncate();
+
+	if (layout.format.isRF64)
+	{
+		output.setPosition(layout.format.ds64Offset + 8);
+		output.writeInt64(riffSize);
+	}
+	else
+	{
+		output.setPosition(4);
+		output.writeInt(int(uint32(riffSize)));
+	}
+
+	output.flush();
+
+	return output.getStatus().wasOk();
+}
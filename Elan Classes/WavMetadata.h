@@ -0,0 +1,153 @@
+#pragma once
+
+#include <unordered_map>
+
+/**
+* Reads and writes the WAV metadata chunks used by WavAudioFile directly from the RIFF
+* structure: 'cue ', 'LIST' 'adtl' (labl, note, ltxt) and 'smpl'.
+*
+* read() walks the chunk headers once, skips over the audio data and never opens an
+* AudioFormatReader. Lookups by cue identifier go through hash maps, see updateIndex().
+* RIFF and RF64 files are both understood.
+*/
+class WavMetadata
+{
+public:
+	struct Cue
+	{
+		uint32 identifier{ 0 };
+		uint32 order{ 0 };                 // dwPosition
+		uint32 chunkId{ 0x61746164 };      // 'data'
+		uint32 chunkStart{ 0 };
+		uint32 blockStart{ 0 };
+		uint32 sampleOffset{ 0 };
+	};
+
+	/** labl and note entries */
+	struct Label
+	{
+		uint32 identifier{ 0 };
+		String text;
+	};
+
+	/** ltxt entries, a cue with a length is a region */
+	struct LabelledText
+	{
+		uint32 identifier{ 0 };
+		uint32 sampleLength{ 0 };
+		uint32 purpose{ 0x206e6772 };      // 'rgn '
+		uint16 country{ 0 };
+		uint16 language{ 0 };
+		uint16 dialect{ 0 };
+		uint16 codePage{ 0 };
+		String text;
+	};
+
+	struct SampleLoop
+	{
+		uint32 identifier{ 0 };
+		uint32 type{ 0 };
+		uint32 start{ 0 };
+		uint32 end{ 0 };
+		uint32 fraction{ 0 };
+		uint32 playCount{ 0 };
+	};
+
+	struct Sampler
+	{
+		uint32 manufacturer{ 0 };
+		uint32 product{ 0 };
+		uint32 samplePeriod{ 0 };
+		uint32 midiUnityNote{ 60 };
+		uint32 midiPitchFraction{ 0 };
+		uint32 smpteFormat{ 0 };
+		uint32 smpteOffset{ 0 };
+		vector<SampleLoop> loops;
+		MemoryBlock samplerData;
+	};
+
+	/** Layout of the file, filled in by read() */
+	struct Format
+	{
+		uint16 formatTag{ 0 };
+		int numChannels{ 0 };
+		double sampleRate{ 0 };
+		int bitsPerSample{ 0 };
+		int blockAlign{ 0 };
+		int64 dataOffset{ 0 };  // file position of the first sample
+		int64 dataSize{ 0 };    // in bytes
+		bool isRF64{ false };
+		int64 ds64Offset{ -1 }; // file position of the ds64 chunk header in RF64 files
+
+		int64 getNumFrames() const { return blockAlign > 0 ? dataSize / blockAlign : 0; }
+	} format;
+
+	/** A top level chunk of the file, filled in by read() */
+	struct ChunkInfo
+	{
+		uint32 id{ 0 };
+		uint32 listType{ 0 }; // for LIST chunks
+		int64 offset{ 0 };    // file position of the chunk header
+		int64 size{ 0 };      // body size without the pad byte
+
+		int64 getEnd() const { return offset + 8 + size; }
+
+		/** cue, LIST adtl, smpl and JUNK, the chunks patchFile() may replace */
+		bool isReplaceable() const;
+	};
+
+	vector<ChunkInfo> chunkList;
+
+	vector<Cue> cues;
+	vector<Label> labels;
+	vector<Label> notes;
+	vector<LabelledText> labelledTexts;
+	Sampler sampler;
+	bool hasSampler{ false };
+
+	/** Returns false if the file is not a RIFF/RF64 WAVE file or has no fmt chunk. */
+	bool read(const File & file);
+	bool read(InputStream & input);
+
+	void clear();
+
+	/** Rebuilds the identifier lookups. read() calls this, call it again after editing the vectors. */
+	void updateIndex();
+
+	const Cue * getCue(uint32 identifier) const;
+	const LabelledText * getLabelledText(uint32 identifier) const;
+	String getLabel(uint32 identifier) const;
+	String getNote(uint32 identifier) const;
+
+	/** Serialised chunks including header and pad byte. Empty when there is nothing to write. */
+	MemoryBlock createCueChunk() const;
+	MemoryBlock createAdtlChunk() const;
+	MemoryBlock createSmplChunk() const;
+	MemoryBlock createChunks() const;
+
+	/**
+	* Writes createChunks() into a complete WAV file without touching the audio data.
+	*
+	* Replaceable chunks after the last chunk that has to be kept are cut off and the new
+	* chunks are written in their place. Replaceable chunks further up the file, e.g. a cue
+	* chunk in front of the data chunk, are renamed to JUNK. Then the RIFF (or ds64) size is
+	* updated. Only the metadata bytes and a few header fields are written.
+	*
+	* Returns false without changing the file if it can't be patched safely, e.g. if it isn't
+	* a WAV file, its chunk sizes run past the end of the file, or a plain RIFF file would
+	* grow past 4 GB.
+	*/
+	bool patchFile(const File & file) const;
+
+	static uint32 chunkName(const char * name) { return ByteOrder::littleEndianInt(name); }
+
+private:
+	std::unordered_map<uint32, size_t> cueIndex;
+	std::unordered_map<uint32, size_t> labelIndex;
+	std::unordered_map<uint32, size_t> noteIndex;
+	std::unordered_map<uint32, size_t> labelledTextIndex;
+
+	void readCueChunk(InputStream & input, int64 size);
+	void readAdtlChunk(InputStream & input, int64 size);
+	void readSmplChunk(InputStream & input, int64 size);
+};
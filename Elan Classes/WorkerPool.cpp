@@ -0,0 +1,128 @@
+#include "ElanClassesHeader.h"
+
+WorkerPool::WorkerPool(int numThreads)
+{
+	if (numThreads <= 0)
+		numThreads = jmax(1, int(std::thread::hardware_concurrency()) - 1);
+
+	for (int i = 0; i < numThreads; ++i)
+		threads.emplace_back([this]() { workerLoop(); });
+}
+
+WorkerPool::~WorkerPool()
+{
+	shutdown();
+}
+
+void WorkerPool::shutdown()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		quit = true;
+	}
+
+	wakeUp.notify_all();
+
+	for (auto & t : threads)
+		t.join();
+
+	threads.clear();
+}
+
+WorkerPool & WorkerPool::getInstance()
+{
+	static WorkerPool instance;
+	return instance;
+}
+
+void WorkerPool::submit(std::function<void()> job)
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+
+		if (!quit)
+		{
+			jobs.push_back(std::move(job));
+			wakeUp.notify_one();
+			return;
+		}
+	}
+
+	// no threads left to run it
+	job();
+}
+
+void WorkerPool::workerLoop()
+{
+	for (;;)
+	{
+		std::function<void()> job;
+
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			wakeUp.wait(lock, [this]() { return quit || !jobs.empty(); });
+
+			if (jobs.empty())
+				return; // quit, once the queue is drained
+
+			job = std::move(jobs.front());
+			jobs.pop_front();
+		}
+
+		job();
+	}
+}
+
+void TaskGroup::run(std::function<void()> job)
+{
+	++pending;
+
+	pool.submit([this, job]()
+	{
+		job();
+
+		// notify under the lock, the group may be destroyed as soon as pending reaches 0
+		std::lock_guard<std::mutex> lock(mutex);
+		--pending;
+		finished.notify_all();
+	});
+}
+
+void TaskGroup::wait()
+{
+	waitUntilPendingAtMost(0);
+}
+
+void TaskGroup::waitUntilPendingAtMost(int n)
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	finished.wait(lock, [this, n]() { return pending.load() <= n; });
+}
+
+bool TaskGroup::waitFor(int timeoutMs)
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	return finished.wait_for(lock, std::chrono::milliseconds(timeoutMs), [this]() { return pending.load() == 0; });
+}
+
+void TaskGroup::parallelFor(size_t n, std::function<void(size_t)> func, WorkerPool & pool)
+{
+	TaskGroup group(pool);
+
+	// a handful of chunks per thread keeps the threads busy when items take different times
+	const size_t numChunks = jmin(n, size_t(jmax(1, pool.getNumThreads())) * 4);
+
+	for (size_t c = 0; c < numChunks; ++c)
+	{
+		const size_t begin = n * c / numChunks;
+		const size_t end = n * (c + 1) / numChunks;
+
+		group.run([&func, begin, end]()
+		{
+			for (size_t i = begin; i < end; ++i)
+				func(i);
+		});
+	}
+
+	group.wait();
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+/**
+* A fixed set of worker threads shared by the whole process, for analysis that runs on audio
+* already decoded into memory. Jobs must not call the REAPER API, keep that on the main thread.
+*
+* Work is submitted through a TaskGroup, which waits for its own jobs only, so several
+* callers can share the pool without waiting on each other's work.
+* Don't wait on a TaskGroup from inside a job, with every worker waiting nothing is left to run.
+*
+* TaskGroup group;
+* for (auto & buffer : buffers)
+*	group.run([&buffer]() { analyse(buffer); });
+* group.wait();
+*
+* The instance is a function-local static, but a plugin must not leave joining its threads to the
+* static destructor. On Windows that runs under the loader lock while the DLL detaches, and joining
+* threads there can deadlock. Shut the pool down when REAPER unloads the plugin:
+*
+* extern "C" REAPER_PLUGIN_DLL_EXPORT int REAPER_PLUGIN_ENTRYPOINT(REAPER_PLUGIN_HINSTANCE instance, reaper_plugin_info_t * rec)
+* {
+*	if (rec == nullptr)
+*	{
+*		WorkerPool::getInstance().shutdown();
+*		return 0;
+*	}
+*	...
+*/
+class WorkerPool
+{
+public:
+	// one thread per core, less one for the thread that submits and waits
+	explicit WorkerPool(int numThreads = 0);
+	~WorkerPool();
+
+	WorkerPool(const WorkerPool &) = delete;
+	WorkerPool & operator=(const WorkerPool &) = delete;
+
+	static WorkerPool & getInstance();
+
+	// Finishes the queued jobs and joins the threads. Later jobs run on the thread that submits them.
+	void shutdown();
+
+	void submit(std::function<void()> job);
+	int getNumThreads() const { return int(threads.size()); } // 0 after shutdown()
+
+private:
+	void workerLoop();
+
+	std::mutex mutex;
+	std::condition_variable wakeUp;
+	std::deque<std::function<void()>> jobs;
+	vector<std::thread> threads;
+	bool quit = false;
+};
+
+class TaskGroup
+{
+public:
+	TaskGroup(WorkerPool & pool = WorkerPool::getInstance()) : pool(pool) {}
+	~TaskGroup() { wait(); }
+
+	TaskGroup(const TaskGroup &) = delete;
+	TaskGroup & operator=(const TaskGroup &) = delete;
+
+	void run(std::function<void()> job);
+
+	// blocks until every job of this group has finished
+	void wait();
+
+	// blocks until at most n jobs of this group are queued or running, to bound memory held by pending jobs
+	void waitUntilPendingAtMost(int n);
+
+	// waits at most timeoutMs, returns true if every job has finished
+	bool waitFor(int timeoutMs);
+
+	int getNumPending() const { return pending.load(); }
+
+	// runs func(i) for i in [0, n) on the pool and waits for all of them
+	static void parallelFor(size_t n, std::function<void(size_t)> func, WorkerPool & pool = WorkerPool::getInstance());
+
+private:
+	WorkerPool & pool;
+	std::atomic<int> pending{ 0 };
+	std::mutex mutex;
+	std::condition_variable finished;
+};
@@ -170,6 +170,44 @@ ITEMLIST ITEM::split(vector<double> splitlist)
 	return SplitItems;
 }
 
+ITEMLIST ITEM::splitToRanges(const vector<RANGE> & ranges)
+{
+	const double start = getStart();
+	const double end = getEnd();
+
+	vector<double> splitlist;
+
+	for (const auto & r : ranges)
+	{
+		if (r.start() > start && r.start() < end)
+			splitlist.push_back(r.start());
+		if (r.end() > start && r.end() < end)
+			splitlist.push_back(r.end());
+	}
+
+	// touching ranges share an edge
+	std::sort(splitlist.begin(), splitlist.end());
+	splitlist.erase(std::unique(splitlist.begin(), splitlist.end()), splitlist.end());
+
+	ITEMLIST kept;
+
+	for (auto piece : split(splitlist))
+	{
+		const double middle = (piece.getStart() + piece.getEnd()) / 2.0;
+
+		bool isInside = false;
+		for (const auto & r : ranges)
+			isInside = isInside || (middle >= r.start() && middle < r.end());
+
+		if (isInside)
+			kept.push_back(piece);
+		else
+			piece.remove();
+	}
+
+	return kept;
+}
+
 int ITEM::getIndex() const { return GetMediaItemInfo_Value(itemPtr, "IP_ITEMNUMBER"); }
 MediaTrack * ITEM::getTrack() const { return GetMediaItem_Track(itemPtr); }
 int ITEM::getTrackIndex() const { return GetMediaTrackInfo_Value(GetMediaItem_Track(itemPtr), "IP_TRACKNUMBER"); }
@@ -692,31 +730,42 @@ double AUDIOFUNCTION::getPeakValueAbsolute(TAKE & take, double * frameIndexOut,
 
 double AUDIOFUNCTION::getPeakValue(TAKE & take, double * frameIndexOut, double * channelIndexOut)
 {
-	double peakValue = 0;
-	double absPeakValue = 0;
-	int frameIndexForPeak = 0;
-	int channelIndexForPeak = take.getFirstChannel();
+	if (take.isFloatAudioLoaded())
+		return getPeakValue(take.getTakeAudioFloat(), take.getFirstChannel(), take.getNumChannelModeChannels(), frameIndexOut, channelIndexOut);
+
+	AUDIODATA & audio = take.getTakeAudio();
 
-	auto func = [&](int ch, int fr)
+	// a take playing its whole file gets the file's pyramid from its sidecar, or builds it once and stores it there
+	if (!audio.hasPeakPyramid() && audio.getNumFrames() > 0)
 	{
-		double value = take[ch][fr];
-		double absValue = abs(value);
+		const TAKESIDECARS & sidecars = TAKESIDECARS::getInstance();
+		const File source = sidecars.getSourceFile(take);
 
-		if (absValue > absPeakValue)
-		{
-			peakValue = value;
-			absPeakValue = absValue;
-			frameIndexForPeak = fr;
-			channelIndexForPeak = ch;
+		if (source != File() && !sidecars.loadPeaks(source, audio))
+			sidecars.storePeaks(source, audio.getPeakPyramid());
+	}
 
-			if (absPeakValue == 1)
-				return;
-		}
-	};
+	return getPeakValue(audio, take.getFirstChannel(), take.getNumChannelModeChannels(), frameIndexOut, channelIndexOut);
+}
 
-	for (int fr = 0; fr < take.getNumFrames(); ++fr)
-		for (int ch = take.getFirstChannel(); ch < take.getNumChannelModeChannels(); ++ch)
-			func(ch, fr);				
+template <typename t> double AUDIOFUNCTION::getPeakValue(const BASIC_AUDIODATA<t> & audio, int firstChannel, int numChannels, double * frameIndexOut, double * channelIndexOut)
+{
+	size_t frameIndexForPeak = 0;
+	int channelIndexForPeak = firstChannel;
+	double peakValue = 0;
+
+	// a pyramid someone already built answers without touching the samples, otherwise one vectorised pass
+	if (audio.hasPeakPyramid())
+	{
+		peakValue = audio.getPeakPyramid().findPeak(audio.getData(), firstChannel, numChannels, &frameIndexForPeak, &channelIndexForPeak);
+	}
+	else
+	{
+		const auto peak = PeakSearch::findPeak(audio.getData(), firstChannel, numChannels);
+		peakValue = peak.value;
+		frameIndexForPeak = peak.frame;
+		channelIndexForPeak = peak.channel;
+	}
 
 	if (frameIndexOut)
 		*frameIndexOut = frameIndexForPeak;
@@ -725,106 +774,711 @@ double AUDIOFUNCTION::getPeakValue(TAKE & take, double * frameIndexOut, double *
 	return peakValue;
 }
 
-vector<double> AUDIOFUNCTION::sumChannelModeChannels(TAKE & take)
+template <typename t> vector<double> AUDIOFUNCTION::sumChannels(const BASIC_AUDIODATA<t> & audio, int firstChannel, int numChannels)
 {
-	vector<double> summed(take.getNumFrames(), 0);
+	vector<double> summed(audio.getNumFrames());
+	sumChannels(audio, firstChannel, numChannels, SampleSpan<double>(summed));
+	return summed;
+}
+
+template <typename t> void AUDIOFUNCTION::sumChannels(const BASIC_AUDIODATA<t> & audio, int firstChannel, int numChannels, SampleSpan<double> output)
+{
+	vector<int> channels;
+	for (int ch = jmax(0, firstChannel); ch < jmin(firstChannel + numChannels, audio.getNumChannels()); ++ch)
+		channels.push_back(ch);
 
-	if (take.getNumChannelModeChannels() == 1)
-		return take.getAudioChannel(take.getFirstChannel());
+	audio.mixdown(MixMatrix::downmix(channels, audio.getNumChannels()), MultichannelSpan<double>(output.data(), 1, output.size(), output.size()));
+}
 
-	for (int fr = 0; fr < take.getNumFrames(); ++fr)
-		for (int ch = take.getFirstChannel(); ch < take.getLastChannel(); ++ch)
-			summed[fr] += take[ch][fr];
+vector<double> AUDIOFUNCTION::sumChannelModeChannels(TAKE & take)
+{
+	if (take.isFloatAudioLoaded())
+		return sumChannels(take.getTakeAudioFloat(), take.getFirstChannel(), take.getNumChannelModeChannels());
 
-	return std::move(summed);
+	return sumChannels(take.getTakeAudio(), take.getFirstChannel(), take.getNumChannelModeChannels());
 }
 
 vector<double> AUDIOFUNCTION::sumSpecificChannels(TAKE& take, vector<int> channelList)
 {
-	vector<double> summed(take.getNumFrames(), 0);
+	vector<double> summed(take.getNumFrames());
+	MultichannelSpan<double> output(summed.data(), 1, summed.size(), summed.size());
 
-	for (int fr = 0; fr < take.getNumFrames(); ++fr)
-	{
-		for (int i = 0; i < channelList.size(); ++i) {
-			int ch = channelList[i];
-			if (ch >= take.getNumChannels()) {
-				continue;
-			}
-			summed[fr] += take[ch][fr];
-		}
-	}
+	// channels the take doesn't have are skipped
+	if (take.isFloatAudioLoaded())
+		take.getTakeAudioFloat().mixdown(MixMatrix::downmix(channelList, take.getTakeAudioFloat().getNumChannels()), output);
+	else
+		take.getTakeAudio().mixdown(MixMatrix::downmix(channelList, take.getTakeAudio().getNumChannels()), output);
 
-	return std::move(summed);
+	return summed;
 }
 
 vector<double> AUDIOFUNCTION::sumAllChannels(TAKE & take)
 {
-	vector<double> summed(take.getNumFrames(), 0);
+	if (take.isFloatAudioLoaded())
+		return sumChannels(take.getTakeAudioFloat(), 0, take.getNumChannels());
 
-	if (take.getNumChannels() == 1)
-		return take.getAudioChannel(0);
+	return sumChannels(take.getTakeAudio(), 0, take.getNumChannels());
+}
 
-	for (int fr = 0; fr < take.getNumFrames(); ++fr)
-		for (int ch = 0; ch < take.getNumChannels(); ++ch)
-			summed[fr] += take[ch][fr];
+double AUDIOFUNCTION::getPeakRMS(TAKE & take, double timeWindowForPeakRMS)
+{
+	if (take.isFloatAudioLoaded())
+		return getPeakRMS(take.getTakeAudioFloat(), take.getFirstChannel(), take.getNumChannelModeChannels(), timeWindowForPeakRMS);
 
-	return std::move(summed);
+	return getPeakRMS(take.getTakeAudio(), take.getFirstChannel(), take.getNumChannelModeChannels(), timeWindowForPeakRMS);
 }
 
-double AUDIOFUNCTION::getPeakRMS(TAKE & take, double timeWindowForPeakRMS)
+template <typename t> double AUDIOFUNCTION::getPeakRMS(const BASIC_AUDIODATA<t> & audio, int firstChannel, int numChannels, double timeWindowForPeakRMS)
 {
-	auto summedAudio = sumChannelModeChannels(take);
-	int numChannels = take.getNumChannelModeChannels();
+	const int lastChannel = jmin(firstChannel + numChannels, audio.getNumChannels());
+
+	if (lastChannel <= firstChannel)
+		return 0;
+
+	// one pass, averaging the channels per frame instead of building a summed copy first
+	SlidingWindowRMS rms(jmax(1, int(audio.getSampleRate() * timeWindowForPeakRMS)));
+	const double gain = 1.0 / (lastChannel - firstChannel);
+	double peakRMS = 0;
+
+	for (int fr = 0; fr < audio.getNumFrames(); ++fr)
+	{
+		double mono = 0;
+		for (int ch = firstChannel; ch < lastChannel; ++ch)
+			mono += audio.getSample(ch, fr);
 
-	if (numChannels > 1)
-		for (auto & value : summedAudio)
-			value /= double(numChannels);
-	
-	return RAPT::getMaxShortTimeRMS<double>(summedAudio.data(), summedAudio.size(), take.getSampleRate()*timeWindowForPeakRMS);
+		double value = rms.process(mono * gain);
+
+		if (rms.isWindowFull())
+			peakRMS = jmax(peakRMS, value);
+	}
+
+	// audio is shorter than the window
+	if (!rms.isWindowFull())
+		peakRMS = rms.getRMS();
+
+	return peakRMS;
 }
 
 bool AUDIOFUNCTION::isAudioSilent(TAKE & take, double minimumAmplitude)
 {
-	for (int ch = take.getFirstChannel(); ch < take.getLastChannel(); ++ch)
-		for (int fr = 0; fr < take.getNumFrames(); ++fr)
-			if (take.getSample(ch, fr) >= minimumAmplitude)
+	if (take.isFloatAudioLoaded())
+		return isAudioSilent(take.getTakeAudioFloat(), take.getFirstChannel(), take.getNumChannelModeChannels(), minimumAmplitude);
+
+	return isAudioSilent(take.getTakeAudio(), take.getFirstChannel(), take.getNumChannelModeChannels(), minimumAmplitude);
+}
+
+template <typename t> bool AUDIOFUNCTION::isAudioSilent(const BASIC_AUDIODATA<t> & audio, int firstChannel, int numChannels, double minimumAmplitude)
+{
+	return audio.isSilent(minimumAmplitude, firstChannel, numChannels);
+}
+
+double AUDIOFUNCTION::getPeakValueStreaming(TAKE & take, double * frameIndexOut, double * channelIndexOut)
+{
+	TAKEBLOCKREADER reader(take, take.getFirstChannel(), take.getNumChannelModeChannels());
+
+	double peakValue = 0;
+	double absPeakValue = 0;
+	size_t frameIndexForPeak = 0;
+	int channelIndexForPeak = reader.getFirstChannel();
+
+	while (absPeakValue < 1.0 && reader.readNextBlock())
+	{
+		const auto peak = PeakSearch::findPeak(reader.getBlock(), 0, reader.getNumChannels());
+
+		if (peak.getMagnitude() > absPeakValue)
+		{
+			peakValue = peak.value;
+			absPeakValue = peak.getMagnitude();
+			frameIndexForPeak = reader.getBlockStart() + peak.frame;
+			channelIndexForPeak = reader.getFirstChannel() + peak.channel;
+		}
+	}
+
+	if (frameIndexOut)
+		*frameIndexOut = double(frameIndexForPeak);
+	if (channelIndexOut)
+		*channelIndexOut = channelIndexForPeak;
+	return peakValue;
+}
+
+double AUDIOFUNCTION::getPeakRMSStreaming(TAKE & take, double timeWindowForPeakRMS)
+{
+	TAKEBLOCKREADER reader(take, take.getFirstChannel(), take.getNumChannelModeChannels());
+
+	if (!reader.isValid() || reader.getNumChannels() == 0)
+		return 0;
+
+	SlidingWindowRMS rms(jmax(1, int(reader.getSampleRate() * timeWindowForPeakRMS)));
+	const double gain = 1.0 / reader.getNumChannels();
+	double peakRMS = 0;
+
+	while (reader.readNextBlock())
+	{
+		for (int fr = 0; fr < reader.getBlockFrames(); ++fr)
+		{
+			double mono = 0;
+			for (int ch = 0; ch < reader.getNumChannels(); ++ch)
+				mono += reader[ch][fr];
+
+			double value = rms.process(mono * gain);
+
+			if (rms.isWindowFull())
+				peakRMS = jmax(peakRMS, value);
+		}
+	}
+
+	// take is shorter than the window
+	if (!rms.isWindowFull())
+		peakRMS = rms.getRMS();
+
+	return peakRMS;
+}
+
+bool AUDIOFUNCTION::isAudioSilentStreaming(TAKE & take, double minimumAmplitude)
+{
+	TAKEBLOCKREADER reader(take, take.getFirstChannel(), take.getNumChannelModeChannels());
+
+	while (reader.readNextBlock())
+		for (int ch = 0; ch < reader.getNumChannels(); ++ch)
+			if (PeakSearch::getMaxMagnitude(reader[ch].data(), reader[ch].size()) >= minimumAmplitude)
 				return false;
+
 	return true;
 }
 
+vector<RANGE> AUDIOFUNCTION::getNonSilentRanges(TAKE & take, double threshold, double holdSeconds, double minimumLengthSeconds, size_t maxSegments)
+{
+	SilenceDetector gate(take.getSampleRate(), threshold, holdSeconds, minimumLengthSeconds);
+	gate.setMaxSegments(maxSegments);
+
+	const AUDIODATA_FLOAT & floatAudio = take.getTakeAudioFloat();
+	const AUDIODATA & audio = take.getTakeAudio();
+
+	if (take.isFloatAudioLoaded())
+		gate.process(floatAudio.getData().getChannelRange(take.getFirstChannel(), take.getNumChannelModeChannels()));
+	else
+		gate.process(audio.getData().getChannelRange(take.getFirstChannel(), take.getNumChannelModeChannels()));
+
+	gate.finish();
+
+	return gate.getRanges(take.getStart());
+}
+
+vector<RANGE> AUDIOFUNCTION::getNonSilentRangesStreaming(TAKE & take, double threshold, double holdSeconds, double minimumLengthSeconds, size_t maxSegments)
+{
+	TAKEBLOCKREADER reader(take, take.getFirstChannel(), take.getNumChannelModeChannels());
+
+	if (!reader.isValid())
+		return {};
+
+	SilenceDetector gate(reader.getSampleRate(), threshold, holdSeconds, minimumLengthSeconds);
+	gate.setMaxSegments(maxSegments);
+
+	// the rest of the take isn't read once enough segments were found
+	while (!gate.isDone() && reader.readNextBlock())
+		gate.process(reader.getBlock());
+
+	gate.finish();
+
+	return gate.getRanges(take.getStart());
+}
+
+LoudnessMeter::Result AUDIOFUNCTION::getLoudness(TAKE & take, double timeWindowForPeakRMS)
+{
+	const TAKESIDECARS & sidecars = TAKESIDECARS::getInstance();
+	const File source = sidecars.getSourceFile(take);
+	LoudnessMeter::Result result;
+
+	if (source != File() && sidecars.loadLoudness(source, timeWindowForPeakRMS, result))
+		return result;
+
+	{
+		TAKEBLOCKREADER reader(take, take.getFirstChannel(), take.getNumChannelModeChannels());
+
+		if (!reader.isValid() || reader.getNumChannels() == 0)
+			return {};
+
+		LoudnessMeter meter(reader.getSampleRate(), reader.getNumChannels(), timeWindowForPeakRMS);
+
+		while (reader.readNextBlock())
+			meter.process(reader.getBlock());
+
+		result = meter.getResult();
+	}
+
+	if (source != File() && result.isValid)
+		sidecars.storeLoudness(source, timeWindowForPeakRMS, result);
+
+	return result;
+}
+
+template <typename Analyse> void AUDIOFUNCTION::analyseTakesInParallel(vector<TAKE> & takes, Analyse analyse, const vector<bool> & skip)
+{
+	TAKESOURCESTATE sources;
+	TaskGroup group;
+
+	// decoded takes waiting for a worker, bounded so memory stays at a few takes
+	const int maxPending = jmax(2, WorkerPool::getInstance().getNumThreads() * 2);
+
+	for (size_t i = 0; i < takes.size(); ++i)
+	{
+		TAKE & take = takes[i];
+
+		if ((i < skip.size() && skip[i]) || !take.isAudio())
+			continue;
+
+		// offline sources are read like online ones and go back offline after the decode
+		const bool isLoaded = take.isFloatAudioLoaded() || take.getTakeAudio().getNumFrames() > 0;
+
+		if (!isLoaded)
+			sources.setOnline(take);
+
+		if (!take.isAudioInitialized())
+			take.initAudio();
+
+		if (!take.isAudioInitialized())
+		{
+			sources.restore(take);
+			continue;
+		}
+
+		const int firstChannel = take.getFirstChannel();
+		const int numChannels = take.getNumChannelModeChannels();
+
+		if (isLoaded)
+		{
+			// already loaded, the caller keeps it until we return
+			if (take.isFloatAudioLoaded())
+			{
+				const AUDIODATA_FLOAT * audio = &take.getTakeAudioFloat();
+				group.run([=]() { analyse(i, audio->getData().getChannelRange(firstChannel, numChannels), audio->getSampleRate()); });
+			}
+			else
+			{
+				const AUDIODATA * audio = &take.getTakeAudio();
+				group.run([=]() { analyse(i, audio->getData().getChannelRange(firstChannel, numChannels), audio->getSampleRate()); });
+			}
+		}
+		else
+		{
+			take.loadAudioAsFloat(false);
+			std::shared_ptr<const AUDIODATA_FLOAT> audio = std::make_shared<AUDIODATA_FLOAT>(std::move(take.getTakeAudioFloat()));
+			take.unloadAudio();
+			sources.restore(take);
+
+			if (audio->getNumFrames() > 0)
+				group.run([=]() { analyse(i, audio->getData().getChannelRange(firstChannel, numChannels), audio->getSampleRate()); });
+		}
+
+		group.waitUntilPendingAtMost(maxPending);
+	}
+
+	group.wait();
+}
+
+namespace
+{
+	struct LoudnessJob
+	{
+		vector<LoudnessMeter::Result> * results;
+		double timeWindowForPeakRMS;
+
+		template <typename t> void operator()(size_t i, MultichannelSpan<const t> audio, int sampleRate) const
+		{
+			(*results)[i] = measureLoudness(audio, sampleRate, timeWindowForPeakRMS);
+		}
+	};
+
+	struct OnsetJob
+	{
+		vector<vector<double>> * results;
+		OnsetDetector::Settings settings;
+
+		template <typename t> void operator()(size_t i, MultichannelSpan<const t> audio, int sampleRate) const
+		{
+			OnsetDetector detector(sampleRate, settings);
+			detector.process(audio);
+			detector.finish();
+			(*results)[i] = detector.getOnsetTimes();
+		}
+	};
+
+	struct PitchJob
+	{
+		vector<PitchDetector::Result> * results;
+		PitchDetector::Settings settings;
+
+		template <typename t> void operator()(size_t i, MultichannelSpan<const t> audio, int sampleRate) const
+		{
+			PitchDetector detector(sampleRate, settings);
+			(*results)[i] = detector.detect(audio);
+		}
+	};
+}
+
+vector<LoudnessMeter::Result> AUDIOFUNCTION::getLoudness(vector<TAKE> & takes, double timeWindowForPeakRMS)
+{
+	vector<LoudnessMeter::Result> results(takes.size());
+
+	// results of takes playing their whole file come from its sidecar, new ones are stored there
+	const TAKESIDECARS & sidecars = TAKESIDECARS::getInstance();
+	vector<File> sources(takes.size());
+	vector<bool> isStored(takes.size(), false);
+
+	for (size_t i = 0; i < takes.size(); ++i)
+	{
+		sources[i] = sidecars.getSourceFile(takes[i]);
+		isStored[i] = sources[i] != File() && sidecars.loadLoudness(sources[i], timeWindowForPeakRMS, results[i]);
+	}
+
+	analyseTakesInParallel(takes, LoudnessJob{ &results, timeWindowForPeakRMS }, isStored);
+
+	for (size_t i = 0; i < takes.size(); ++i)
+		if (!isStored[i] && sources[i] != File() && results[i].isValid)
+			sidecars.storeLoudness(sources[i], timeWindowForPeakRMS, results[i]);
+
+	return results;
+}
+
+vector<double> AUDIOFUNCTION::detectOnsets(TAKE & take, const OnsetDetector::Settings & settings)
+{
+	// for a take playing its whole file, seconds from the item start are seconds from the file start
+	const TAKESIDECARS & sidecars = TAKESIDECARS::getInstance();
+	const File source = sidecars.getSourceFile(take);
+	vector<double> onsets;
+
+	if (source != File() && sidecars.loadOnsets(source, settings, onsets))
+		return onsets;
+
+	onsets = detectOnsetsOfAudio(take, settings);
+
+	if (source != File())
+		sidecars.storeOnsets(source, settings, onsets);
+
+	return onsets;
+}
+
+vector<double> AUDIOFUNCTION::detectOnsetsOfAudio(TAKE & take, const OnsetDetector::Settings & settings)
+{
+	const AUDIODATA_FLOAT & floatAudio = take.getTakeAudioFloat();
+	const AUDIODATA & audio = take.getTakeAudio();
+
+	if (take.isFloatAudioLoaded() || audio.getNumFrames() > 0)
+	{
+		OnsetDetector detector(take.getSampleRate(), settings);
+
+		if (take.isFloatAudioLoaded())
+			detector.process(floatAudio.getData().getChannelRange(take.getFirstChannel(), take.getNumChannelModeChannels()));
+		else
+			detector.process(audio.getData().getChannelRange(take.getFirstChannel(), take.getNumChannelModeChannels()));
+
+		detector.finish();
+		return detector.getOnsetTimes();
+	}
+
+	TAKEBLOCKREADER reader(take, take.getFirstChannel(), take.getNumChannelModeChannels());
+
+	if (!reader.isValid())
+		return {};
+
+	OnsetDetector detector(reader.getSampleRate(), settings);
+
+	while (reader.readNextBlock())
+		detector.process(reader.getBlock());
+
+	detector.finish();
+	return detector.getOnsetTimes();
+}
+
+vector<vector<double>> AUDIOFUNCTION::detectOnsets(vector<TAKE> & takes, const OnsetDetector::Settings & settings)
+{
+	vector<vector<double>> results(takes.size());
+
+	const TAKESIDECARS & sidecars = TAKESIDECARS::getInstance();
+	vector<File> sources(takes.size());
+	vector<bool> isStored(takes.size(), false);
+
+	for (size_t i = 0; i < takes.size(); ++i)
+	{
+		sources[i] = sidecars.getSourceFile(takes[i]);
+		isStored[i] = sources[i] != File() && sidecars.loadOnsets(sources[i], settings, results[i]);
+	}
+
+	analyseTakesInParallel(takes, OnsetJob{ &results, settings }, isStored);
+
+	// takes that couldn't be read are left out, an empty result is only stored for audio that was analysed
+	for (size_t i = 0; i < takes.size(); ++i)
+		if (!isStored[i] && sources[i] != File() && takes[i].isAudioInitialized())
+			sidecars.storeOnsets(sources[i], settings, results[i]);
+
+	return results;
+}
+
+void AUDIOFUNCTION::markOnsets(vector<TAKE> & takes, const TAKEMARKER::MarkerPreset & preset, const OnsetDetector::Settings & settings)
+{
+	auto onsets = detectOnsets(takes, settings);
+
+	PreventUIRefresh(1);
+
+	for (size_t i = 0; i < takes.size(); ++i)
+	{
+		TAKE & take = takes[i];
+
+		if (!take.isAudioInitialized())
+			continue;
+
+		// item time to take marker time
+		const double offset = take.getStartOffset();
+		const double rate = take.getRate();
+
+		vector<double> positions;
+		positions.reserve(onsets[i].size());
+
+		for (double time : onsets[i])
+			positions.push_back(offset + time * rate);
+
+		TAKEMARKER::replacePreset(take, preset, positions);
+	}
+
+	PreventUIRefresh(-1);
+	UpdateArrange();
+}
+
+PitchDetector::Result AUDIOFUNCTION::detectPitch(TAKE & take, const PitchDetector::Settings & settings)
+{
+	const bool wasLoaded = take.isFloatAudioLoaded() || take.getTakeAudio().getNumFrames() > 0;
+
+	if (!wasLoaded)
+	{
+		if (!take.isAudioInitialized())
+			take.initAudio();
+
+		if (!take.isAudioInitialized())
+			return {};
+
+		take.loadAudioAsFloat(false);
+	}
+
+	PitchDetector detector(take.getSampleRate(), settings);
+	PitchDetector::Result result;
+
+	const AUDIODATA_FLOAT & floatAudio = take.getTakeAudioFloat();
+	const AUDIODATA & audio = take.getTakeAudio();
+
+	if (take.isFloatAudioLoaded())
+		result = detector.detect(floatAudio.getData().getChannelRange(take.getFirstChannel(), take.getNumChannelModeChannels()));
+	else
+		result = detector.detect(audio.getData().getChannelRange(take.getFirstChannel(), take.getNumChannelModeChannels()));
+
+	if (!wasLoaded)
+		take.unloadAudio();
+
+	return result;
+}
+
+vector<PitchDetector::Result> AUDIOFUNCTION::detectPitch(vector<TAKE> & takes, const PitchDetector::Settings & settings)
+{
+	vector<PitchDetector::Result> results(takes.size());
+
+	analyseTakesInParallel(takes, PitchJob{ &results, settings });
+
+	return results;
+}
+
+void AUDIOFUNCTION::tagPitch(vector<TAKE> & takes, const String & tag, const PitchDetector::Settings & settings)
+{
+	auto pitches = detectPitch(takes, settings);
+
+	PreventUIRefresh(1);
+
+	for (size_t i = 0; i < takes.size(); ++i)
+		if (pitches[i].isValid())
+			takes[i].setTag(tag, MIDI(int(std::round(pitches[i].getMidiNote()))).getName());
+
+	PreventUIRefresh(-1);
+	UpdateArrange();
+}
+
+template double AUDIOFUNCTION::getPeakValue(const AUDIODATA &, int, int, double *, double *);
+template double AUDIOFUNCTION::getPeakValue(const AUDIODATA_FLOAT &, int, int, double *, double *);
+template vector<double> AUDIOFUNCTION::sumChannels(const AUDIODATA &, int, int);
+template vector<double> AUDIOFUNCTION::sumChannels(const AUDIODATA_FLOAT &, int, int);
+template void AUDIOFUNCTION::sumChannels(const AUDIODATA &, int, int, SampleSpan<double>);
+template void AUDIOFUNCTION::sumChannels(const AUDIODATA_FLOAT &, int, int, SampleSpan<double>);
+template double AUDIOFUNCTION::getPeakRMS(const AUDIODATA &, int, int, double);
+template double AUDIOFUNCTION::getPeakRMS(const AUDIODATA_FLOAT &, int, int, double);
+template bool AUDIOFUNCTION::isAudioSilent(const AUDIODATA &, int, int, double);
+template bool AUDIOFUNCTION::isAudioSilent(const AUDIODATA_FLOAT &, int, int, double);
+
 void AUDIOPROCESS::processTakeList(TAKELIST& list, std::function<void(TAKE&)> perTakeFunction)
 {
-	prepareToStart();
+	TAKESOURCESTATE sources;
 
 	for (auto & take : list)
 	{
 		if (!take.isAudio())
 			continue;
 
-		loadTake(take);
+		loadTake(take, sources);
 
 		perTakeFunction(take);
 
-		unloadTake(take);
+		unloadTake(take, sources);
 	}
-
-	prepareToEnd();
 }
 
 void AUDIOPROCESS::processTakeList(vector<TAKE>& list, std::function<void(TAKE&)> perTakeFunction)
 {
-	prepareToStart();
+	TAKESOURCESTATE sources;
 
 	for (auto& take : list)
 	{
-		loadTake(take);
+		loadTake(take, sources);
 
 		perTakeFunction(take);
 
-		unloadTake(take);
+		unloadTake(take, sources);
 	}
+}
 
-	prepareToEnd();
+void AUDIOPROCESS::processTakeList(TAKELIST& list, function<bool(TAKE&, MultichannelSpan<const double>, size_t)> perBlockFunction, int blockSize)
+{
+	processTakeList(list.list, perBlockFunction, blockSize);
+}
+
+void AUDIOPROCESS::processTakeList(vector<TAKE>& list, function<bool(TAKE&, MultichannelSpan<const double>, size_t)> perBlockFunction, int blockSize)
+{
+	TAKESOURCESTATE sources;
+
+	for (auto & take : list)
+	{
+		if (!take.isAudio())
+			continue;
+
+		sources.setOnline(take);
+
+		{
+			// the reader holds the accessor, it has to be gone before the source goes back offline
+			TAKEBLOCKREADER reader(take, take.getFirstChannel(), take.getNumChannelModeChannels(), blockSize);
+
+			while (reader.readNextBlock())
+				if (!perBlockFunction(take, reader.getBlock(), reader.getBlockStart()))
+					break;
+		}
+
+		sources.restore(take);
+	}
+}
+
+void AUDIOPROCESS::processTakeListParallel(TAKELIST& list, function<void(TAKEJOB&)> perTakeFunction, const Prefetch & prefetch)
+{
+	processTakeListParallel(list.list, perTakeFunction, prefetch);
+}
+
+void AUDIOPROCESS::processTakeListParallel(vector<TAKE>& list, function<void(TAKEJOB&)> perTakeFunction, const Prefetch & prefetch)
+{
+	runTakePipeline(list, perTakeFunction, prefetch, nullptr);
+}
+
+String TAKETIMING::toString() const
+{
+	return "decode " + String(decodeMs, 1) + " ms, compute " + String(computeMs, 1) + " ms, write " + String(writeMs, 1) + " ms";
+}
+
+void AUDIOPROCESS::runTakePipeline(vector<TAKE>& list, function<void(TAKEJOB&)> perTakeFunction, const Prefetch & prefetch, function<void(TAKEJOB&)> finishedFunction)
+{
+	struct Job
+	{
+		std::shared_ptr<const AUDIODATA> audio; // released by the worker when done
+		std::unique_ptr<TAKEJOB> takeJob;
+		std::atomic<bool> done{ false };
+	};
+
+	std::deque<std::unique_ptr<Job>> jobs; // in take order, until their writes have run
+
+	// writes only run once every earlier take's have, so they happen in take order whatever order the workers finish in
+	auto runFinishedWrites = [&jobs, &finishedFunction]()
+	{
+		while (!jobs.empty() && jobs.front()->done.load(std::memory_order_acquire))
+		{
+			TAKEJOB & takeJob = *jobs.front()->takeJob;
+			const double start = Time::getMillisecondCounterHiRes();
+
+			for (auto & call : takeJob.writes)
+				call();
+
+			takeJob.timing.writeMs = Time::getMillisecondCounterHiRes() - start;
+
+			if (finishedFunction)
+				finishedFunction(takeJob);
+
+			jobs.pop_front();
+		}
+	};
+
+	const function<void(TAKEJOB&)> * perTake = &perTakeFunction;
+	const int depth = prefetch.depth > 0 ? prefetch.depth : jmax(2, WorkerPool::getInstance().getNumThreads() * 2);
+	std::atomic<size_t> bytesInFlight{ 0 };
+	std::atomic<size_t> * bytes = &bytesInFlight;
+	TAKESOURCESTATE sources;
+	TaskGroup group;
+
+	// waits for jobs to finish one at a time until there is room for another take, running writes as they come in
+	auto waitForRoom = [&](int maxJobs)
+	{
+		runFinishedWrites();
+
+		while (group.getNumPending() > 0 && (group.getNumPending() > maxJobs || bytesInFlight.load() > prefetch.maxBytes))
+		{
+			group.waitUntilPendingAtMost(group.getNumPending() - 1);
+			runFinishedWrites();
+		}
+	};
+
+	for (size_t i = 0; i < list.size(); ++i)
+	{
+		TAKE & take = list[i];
+
+		if (!take.isAudio())
+			continue;
+
+		// one slot for the take about to be decoded
+		waitForRoom(depth - 1);
+
+		const double decodeStart = Time::getMillisecondCounterHiRes();
+
+		loadTake(take, sources);
+
+		std::unique_ptr<Job> job(new Job);
+		job->audio = std::make_shared<AUDIODATA>(std::move(take.getTakeAudio()));
+		job->takeJob.reset(new TAKEJOB(take, *job->audio, i, take.getFirstChannel(), take.getNumChannelModeChannels()));
+
+		unloadTake(take, sources);
+
+		job->takeJob->timing.decodeMs = Time::getMillisecondCounterHiRes() - decodeStart;
+
+		if (job->audio->getNumFrames() == 0)
+			continue;
+
+		const size_t audioBytes = size_t(job->audio->getNumChannels()) * job->audio->getNumFrames() * sizeof(double);
+		bytesInFlight += audioBytes;
+
+		Job * j = job.get();
+		jobs.push_back(std::move(job));
+
+		group.run([j, perTake, bytes, audioBytes]()
+		{
+			const double start = Time::getMillisecondCounterHiRes();
+			(*perTake)(*j->takeJob);
+			j->takeJob->timing.computeMs = Time::getMillisecondCounterHiRes() - start;
+			j->audio.reset();
+			*bytes -= audioBytes;
+			j->done.store(true, std::memory_order_release);
+		});
+	}
+
+	group.wait();
+	runFinishedWrites();
 }
 
 void AUDIOPROCESS::prepareToStart()
@@ -845,7 +1499,7 @@ void AUDIOPROCESS::loadTake(TAKE & take)
 	PROJECT::selectItem(take.getMediaItemPtr());
 	PROJECT::setSelectedItemsOnline();
 	take.initAudio();
-	take.loadAudio();
+	take.loadAudio(false);
 }
 
 void AUDIOPROCESS::unloadTake(TAKE & take)
@@ -855,6 +1509,72 @@ void AUDIOPROCESS::unloadTake(TAKE & take)
 	PROJECT::unselectItem(take.getMediaItemPtr());
 }
 
+void AUDIOPROCESS::loadTake(TAKE & take, TAKESOURCESTATE & sources)
+{
+	sources.setOnline(take);
+	take.initAudio();
+	take.loadAudio(false);
+}
+
+void AUDIOPROCESS::unloadTake(TAKE & take, TAKESOURCESTATE & sources)
+{
+	take.unloadAudio();
+	sources.restore(take);
+}
+
+String AUDIOPROCESS::benchmarkTakeLoading(vector<TAKE>& takes)
+{
+	const int numTakes = int(takes.size());
+	const int numItems = PROJECT::countItems();
+
+	if (numTakes == 0)
+		return "No takes\n";
+
+	// whole project way, the calls counted are the ones the PROJECT functions make
+	int64 start = Time::getHighResolutionTicks();
+
+	const int numSelected = PROJECT::countSelectedItems();
+	prepareToStart();
+
+	for (auto & take : takes)
+	{
+		PROJECT::selectItem(take.getMediaItemPtr());
+		PROJECT::setSelectedItemsOnline();
+		PROJECT::setSelectedItemsOffline();
+		PROJECT::unselectItem(take.getMediaItemPtr());
+	}
+
+	prepareToEnd();
+
+	const double actionSeconds = Time::highResolutionTicksToSeconds(Time::getHighResolutionTicks() - start);
+	// Not counted as they happen, worked out from the calls the PROJECT functions above make: one Main_OnCommand per action,
+	// each walking all numItems items, CountSelectedMediaItems and a GetSelectedMediaItem per selected item to save the
+	// selection, a B_UISEL write per item to restore it, and per take two B_UISEL writes and two GetMediaItemTake_Item.
+	const int64 actions = 4 + 2 * int64(numTakes);
+	const int64 actionCalls = actions + 1 + 2 * int64(numSelected) + 4 * int64(numTakes);
+
+	// targeted
+	TAKESOURCESTATE sources;
+	start = Time::getHighResolutionTicks();
+
+	for (auto & take : takes)
+	{
+		sources.setOnline(take);
+		sources.restore(take);
+	}
+
+	const double targetedSeconds = Time::highResolutionTicksToSeconds(Time::getHighResolutionTicks() - start);
+
+	String report;
+	report << "Take loading: " << numTakes << " takes, " << numItems << " items in project\n";
+	report << "selection and actions: an estimated " << String(double(actionCalls) / numTakes, 2) << " API calls per take, "
+		<< actions << " whole project actions, " << String(actionSeconds * 1000.0 / numTakes, 3) << " ms per take\n";
+	report << "TAKESOURCESTATE: " << String(double(sources.getNumApiCalls()) / numTakes, 2) << " API calls per take, "
+		<< "0 whole project actions, " << String(targetedSeconds * 1000.0 / numTakes, 3) << " ms per take\n";
+
+	return report;
+}
+
 TAKE::TAKE(const vector<vector<double>> & multichannelAudio, FILE fileToWriteTo)
 {
 
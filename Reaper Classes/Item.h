@@ -74,6 +74,10 @@ public:
 	// Returns ITEMLIST of items created from splitting including itself using global time.
 	ITEMLIST split(vector<double> splitlist);
 
+	// Splits at the edges of the ranges and removes the parts outside all ranges, global time.
+	// Returns the items left, one per range that overlaps the item. Takes the output of AUDIOFUNCTION::getNonSilentRanges.
+	ITEMLIST splitToRanges(const vector<RANGE> & ranges);
+
 	MediaItem* getPointer() { return itemPtr; }
 
 	/* GETTER */
@@ -324,11 +328,136 @@ public:
 
 	static vector<double> sumChannelModeChannels(TAKE & take);
 	static vector<double> sumAllChannels(TAKE & take);
-	vector<double> sumSpecificChannels(TAKE& take, vector<int> channelList);
+	static vector<double> sumSpecificChannels(TAKE& take, vector<int> channelList);
 
 	static double getPeakRMS(TAKE & take, double timeWindowForPeakRMS);
 
 	static bool isAudioSilent(TAKE & take, double minimumAmplitude);
+
+	// The TAKE functions above use whichever of loadAudio() or loadAudioAsFloat() was called.
+	// These work directly on float or double AUDIODATA without converting it,
+	// analysing channels [firstChannel, firstChannel + numChannels).
+	template <typename t> static double getPeakValue(const BASIC_AUDIODATA<t> & audio, int firstChannel, int numChannels, double * frameIndexOut = nullptr, double * channelIndexOut = nullptr);
+	template <typename t> static vector<double> sumChannels(const BASIC_AUDIODATA<t> & audio, int firstChannel, int numChannels);
+	// sums into the caller's buffer, frames up to the shorter of audio and output
+	template <typename t> static void sumChannels(const BASIC_AUDIODATA<t> & audio, int firstChannel, int numChannels, SampleSpan<double> output);
+	template <typename t> static double getPeakRMS(const BASIC_AUDIODATA<t> & audio, int firstChannel, int numChannels, double timeWindowForPeakRMS);
+	template <typename t> static bool isAudioSilent(const BASIC_AUDIODATA<t> & audio, int firstChannel, int numChannels, double minimumAmplitude);
+
+	// Streaming versions read the take's channel mode channels block by block with TAKEBLOCKREADER.
+	// The take does not need to be loaded, memory use stays at one block and they stop as soon as the answer is known.
+	static double getPeakValueStreaming(TAKE & take, double * frameIndexOut = nullptr, double * channelIndexOut = nullptr);
+	static double getPeakRMSStreaming(TAKE & take, double timeWindowForPeakRMS);
+	static bool isAudioSilentStreaming(TAKE & take, double minimumAmplitude);
+
+	// Non-silent parts of the channel mode channels in project time, see SilenceDetector for threshold, hold and minimum length.
+	// The first version uses the loaded audio, the streaming version reads the take block by block.
+	// Both stop after maxSegments ranges, 0 for all of them, so getNonSilentRangesStreaming(take, t, 0.1, 0, 1) stops reading once the first sound has ended.
+	static vector<RANGE> getNonSilentRanges(TAKE & take, double threshold, double holdSeconds = 0.1, double minimumLengthSeconds = 0.0, size_t maxSegments = 0);
+	static vector<RANGE> getNonSilentRangesStreaming(TAKE & take, double threshold, double holdSeconds = 0.1, double minimumLengthSeconds = 0.0, size_t maxSegments = 0);
+
+	// getPeakValue(TAKE&) on double audio, getLoudness and detectOnsets keep the results of takes that play their
+	// whole source file in its AnalysisSidecar and reuse them while the file is unchanged, see TAKESIDECARS.
+
+	// EBU R128 loudness, true peak and peak RMS of the channel mode channels, streamed in one pass. See LoudnessMeter.
+	static LoudnessMeter::Result getLoudness(TAKE & take, double timeWindowForPeakRMS = 0.3);
+
+	// Measures many takes at once. Takes are decoded one after the other on the calling thread,
+	// which must be the main thread, and measured on the WorkerPool while the next one decodes.
+	// Takes that are already loaded are measured in place, others are loaded as float and unloaded again,
+	// offline sources are brought online for their decode with TAKESOURCESTATE.
+	// Results are in the order of the takes, takes without audio get an invalid result.
+	static vector<LoudnessMeter::Result> getLoudness(vector<TAKE> & takes, double timeWindowForPeakRMS = 0.3);
+
+	// Spectral flux onsets of the channel mode channels in seconds from the start of the item, see OnsetDetector.
+	// Uses the loaded audio, or streams the take block by block if none is loaded.
+	static vector<double> detectOnsets(TAKE & take, const OnsetDetector::Settings & settings = OnsetDetector::Settings());
+
+	// Detects the onsets of many takes in parallel, the same way as the batch getLoudness.
+	static vector<vector<double>> detectOnsets(vector<TAKE> & takes, const OnsetDetector::Settings & settings = OnsetDetector::Settings());
+
+	// Detects the onsets of many takes in parallel and puts a take marker with the preset's name and colour on each,
+	// replacing markers of that preset from an earlier run. One TAKEMARKER::replacePreset per take, UI refresh held throughout.
+	static void markOnsets(vector<TAKE> & takes, const TAKEMARKER::MarkerPreset & preset = TAKEMARKER::atk, const OnsetDetector::Settings & settings = OnsetDetector::Settings());
+
+	// Pitch of the steady state of the channel mode channels, see PitchDetector.
+	// Uses the loaded audio, or loads the take as float for the duration of the call.
+	static PitchDetector::Result detectPitch(TAKE & take, const PitchDetector::Settings & settings = PitchDetector::Settings());
+
+	// Detects the pitch of many takes in parallel, the same way as the batch getLoudness.
+	static vector<PitchDetector::Result> detectPitch(vector<TAKE> & takes, const PitchDetector::Settings & settings = PitchDetector::Settings());
+
+	// Detects the pitch of many takes in parallel and writes the name of the nearest note to the tag,
+	// the "n" tag read by the noteclass property by default. Takes without a clear pitch keep their tag.
+	static void tagPitch(vector<TAKE> & takes, const String & tag = "n", const PitchDetector::Settings & settings = PitchDetector::Settings());
+
+protected:
+	// Decodes the takes one after the other on the calling thread, which must be the main thread, and calls
+	// analyse(index, channel mode channels, sample rate) for each on the WorkerPool while the next one decodes.
+	// analyse gets a MultichannelSpan of const float or const double. Takes whose entry in skip is true are left out.
+	template <typename Analyse> static void analyseTakesInParallel(vector<TAKE> & takes, Analyse analyse, const vector<bool> & skip = vector<bool>());
+
+	// detectOnsets without the sidecar
+	static vector<double> detectOnsetsOfAudio(TAKE & take, const OnsetDetector::Settings & settings);
+};
+
+// Milliseconds spent on one take by AUDIOPROCESS::processTakeListParallel and mapTakes
+struct TAKETIMING
+{
+	double decodeMs = 0;  // source online, audio read and source back, main thread
+	double computeMs = 0; // the per-take function, on a worker
+	double writeMs = 0;   // the queued writes, main thread
+
+	double getTotalMs() const { return decodeMs + computeMs + writeMs; }
+
+	// "decode 12.3 ms, compute 4.5 ms, write 0.1 ms", for logs
+	String toString() const;
+};
+
+/*
+What the per-take function of AUDIOPROCESS::processTakeListParallel gets. The function runs on a
+worker thread, so it reads the decoded audio and the values below, which were read on the main
+thread, and must not call the REAPER API, not even through take. Changes to the take go through
+write(), the calls run on the main thread after the function returns, in the order of the takes.
+
+AUDIOPROCESS::processTakeListParallel(takes, [](TAKEJOB & job)
+{
+	const double peak = AUDIOFUNCTION::getPeakValue(job.audio, job.firstChannel, job.numChannels);
+	TAKE * take = &job.take;
+	if (peak > 0)
+		job.write([take, peak]() { take->setVolume(take->getVolume() / peak); });
+});
+*/
+class TAKEJOB
+{
+public:
+	TAKEJOB(TAKE & take, const AUDIODATA & audio, size_t index, int firstChannel, int numChannels)
+		: take(take), audio(audio), index(index), firstChannel(firstChannel), numChannels(numChannels) {}
+
+	TAKE & take;              // only touch it inside a write
+	const AUDIODATA & audio;  // every channel of the take, freed when the function returns so don't use it in a write
+	const size_t index;       // in the list
+	const int firstChannel;     // the channel mode channels are [firstChannel, firstChannel + numChannels)
+	const int numChannels;
+
+	// queues a call for the main thread
+	void write(function<void()> call) { writes.push_back(std::move(call)); }
+
+	// complete once the writes have run
+	const TAKETIMING & getTiming() const { return timing; }
+
+protected:
+	friend class AUDIOPROCESS;
+	vector<function<void()>> writes;
+	TAKETIMING timing;
+};
+
+// One entry of AUDIOPROCESS::mapTakes
+template <typename R> struct TAKERESULT
+{
+	R value = R();
+	TAKETIMING timing;
+	bool isProcessed = false; // false for MIDI takes and takes without audio, value is R() then
 };
 
 class AUDIOPROCESS
@@ -337,19 +466,112 @@ public:
 	static void processTakeList(TAKELIST& list, function<void(TAKE&)> perTakeFunction);
 	static void processTakeList(vector<TAKE>& list, function<void(TAKE&)> perTakeFunction);
 
+	// Streams the channel mode channels of each take through perBlockFunction(take, block, frame of the block's start
+	// in the take) in blocks of blockSize frames, the last one shorter, instead of decoding the whole take. Memory stays
+	// at one block. Return false to stop reading the take, the next one starts. Main thread only, see TAKEBLOCKREADER.
+	static void processTakeList(TAKELIST& list, function<bool(TAKE&, MultichannelSpan<const double>, size_t)> perBlockFunction, int blockSize = 4096);
+	static void processTakeList(vector<TAKE>& list, function<bool(TAKE&, MultichannelSpan<const double>, size_t)> perBlockFunction, int blockSize = 4096);
+
+	// How far processTakeListParallel decodes ahead of the workers
+	struct Prefetch
+	{
+		int depth = 0;                        // decoded takes queued or being processed, 2 is double buffering, 0 is twice the number of workers
+		size_t maxBytes = size_t(512) << 20;  // of decoded audio held at once, one take is always let through however large
+	};
+
+	// Like processTakeList, in three stages: the takes are decoded one after the other on the calling thread,
+	// which must be the main thread, perTakeFunction runs on the WorkerPool while the next ones decode, and
+	// the writes it queued run back on the main thread, see TAKEJOB. Decoding waits while prefetch.depth takes
+	// or prefetch.maxBytes of audio are in flight.
+	static void processTakeListParallel(TAKELIST& list, function<void(TAKEJOB&)> perTakeFunction, const Prefetch & prefetch);
+	static void processTakeListParallel(vector<TAKE>& list, function<void(TAKEJOB&)> perTakeFunction, const Prefetch & prefetch);
+	static void processTakeListParallel(TAKELIST& list, function<void(TAKEJOB&)> perTakeFunction) { processTakeListParallel(list, perTakeFunction, Prefetch()); }
+	static void processTakeListParallel(vector<TAKE>& list, function<void(TAKEJOB&)> perTakeFunction) { processTakeListParallel(list, perTakeFunction, Prefetch()); }
+
+	/**
+	* Runs mapFunction over the takes the way processTakeListParallel does and returns what it returned for
+	* each take, with its timings, in the order of the takes. R must be default constructible and is written
+	* from the workers into the take's own entry, so nothing needs to be captured by reference.
+	*
+	* auto peaks = AUDIOPROCESS::mapTakes<double>(takes, [](TAKEJOB & job) { return AUDIOFUNCTION::getPeakValue(job.audio, job.firstChannel, job.numChannels); });
+	* for (size_t i = 0; i < peaks.size(); ++i)
+	*	if (peaks[i].timing.getTotalMs() > 1000) DBG(takes[i].getName() + ": " + peaks[i].timing.toString());
+	*/
+	template <typename R> static vector<TAKERESULT<R>> mapTakes(vector<TAKE>& list, function<R(TAKEJOB&)> mapFunction, const Prefetch & prefetch)
+	{
+		vector<TAKERESULT<R>> results(list.size());
+		vector<TAKERESULT<R>> * r = &results;
+		const function<R(TAKEJOB&)> * f = &mapFunction;
+
+		runTakePipeline(list, [r, f](TAKEJOB & job) { (*r)[job.index].value = (*f)(job); }, prefetch,
+			[r](TAKEJOB & job) { (*r)[job.index].timing = job.getTiming(); (*r)[job.index].isProcessed = true; });
+
+		return results;
+	}
+
+	template <typename R> static vector<TAKERESULT<R>> mapTakes(vector<TAKE>& list, function<R(TAKEJOB&)> mapFunction)
+	{
+		return mapTakes<R>(list, mapFunction, Prefetch());
+	}
+
+	/**
+	* Maps the takes in parallel like mapTakes and folds the results into initial on the main thread with
+	* reduceFunction(accumulated, result), strictly in the order of the takes and as soon as every earlier take
+	* is done, so results don't pile up. Takes without audio are skipped.
+	*
+	* double loudest = AUDIOPROCESS::reduceTakes<double, double>(takes, getPeak, 0.0,
+	*	[](double a, const TAKERESULT<double> & r) { return jmax(a, r.value); });
+	*/
+	template <typename R, typename A> static A reduceTakes(vector<TAKE>& list, function<R(TAKEJOB&)> mapFunction, A initial, function<A(A, const TAKERESULT<R>&)> reduceFunction, const Prefetch & prefetch)
+	{
+		vector<TAKERESULT<R>> results(list.size());
+		vector<TAKERESULT<R>> * r = &results;
+		const function<R(TAKEJOB&)> * f = &mapFunction;
+		A accumulated = std::move(initial);
+
+		runTakePipeline(list, [r, f](TAKEJOB & job) { (*r)[job.index].value = (*f)(job); }, prefetch,
+			[r, &accumulated, &reduceFunction](TAKEJOB & job)
+		{
+			TAKERESULT<R> & result = (*r)[job.index];
+			result.timing = job.getTiming();
+			result.isProcessed = true;
+			accumulated = reduceFunction(std::move(accumulated), result);
+			result = TAKERESULT<R>();
+		});
+
+		return accumulated;
+	}
+
+	template <typename R, typename A> static A reduceTakes(vector<TAKE>& list, function<R(TAKEJOB&)> mapFunction, A initial, function<A(A, const TAKERESULT<R>&)> reduceFunction)
+	{
+		return reduceTakes<R, A>(list, mapFunction, std::move(initial), reduceFunction, Prefetch());
+	}
+
 	static void shorthand(TAKE& take, function<void(int,int)> func)
 	{
 		for (int fr = 0; fr < take.getNumFrames(); ++fr)
-			for (int ch = take.getFirstChannel(); ch < take.getLastChannel(); ++ch)
+			for (int ch = take.getFirstChannel(); ch <= take.getLastChannel(); ++ch)
 				func(ch, fr);
 	}
 
+	// Whole project way of getting takes on and off line: every item offline, then each take selected and
+	// put online by action. The process functions use the TAKESOURCESTATE overloads of loadTake and unloadTake.
 	static void prepareToStart();
 	static void prepareToEnd();
 	static void loadTake(TAKE& take);
 	static void unloadTake(TAKE& take);
+
+	// Only the take's source goes online for the decode and back to its earlier state after, the selection is left alone
+	static void loadTake(TAKE& take, TAKESOURCESTATE& sources);
+	static void unloadTake(TAKE& take, TAKESOURCESTATE& sources);
+
+	// Times getting the takes on and off line around an empty callback, without decoding, once the way of
+	// prepareToStart and loadTake and once with TAKESOURCESTATE. Reports REAPER API calls and ms per take,
+	// counted for TAKESOURCESTATE and estimated from what the PROJECT functions call for the old way.
+	static String benchmarkTakeLoading(vector<TAKE>& takes);
 
-	template <typename t> static vector<t> convertSampleRate(const vector<t>& audio, int incomingSampleRate, int outgoingSampleRate)
+	// Polyphase resampling, see Resampler. For streaming use a Resampler directly.
+	template <typename t> static vector<t> convertSampleRate(const vector<t>& audio, int incomingSampleRate, int outgoingSampleRate, Resampler::Quality quality = Resampler::normal)
 	{
 		if (incomingSampleRate <= 0 || outgoingSampleRate <= 0)
 			jassertfalse;
@@ -357,15 +579,20 @@ public:
 		if (incomingSampleRate == outgoingSampleRate || audio.empty())
 			return audio;
 
-		int numSamples = audio.size();
-		double resampleFactor = double(incomingSampleRate) / double(outgoingSampleRate);
-		int newSampleSize = int(ceil(numSamples * 1.0 / resampleFactor));
+		auto converted = resampleBuffer(MultichannelSpan<const t>(audio.data(), 1, audio.size(), audio.size()), incomingSampleRate, outgoingSampleRate, quality);
 
-		vector<t> returnSignal;
-		returnSignal.resize(newSampleSize, 0);
+		return converted[0].toVector();
+	}
 
-		RAPT::rsResampler<t, t>::transposeSinc(audio.data(), numSamples, returnSignal.data(), newSampleSize, t(resampleFactor));
+	// All channels in one pass, equal rates return a copy
+	template <typename t> static PlanarBuffer<t> convertSampleRate(MultichannelSpan<const t> audio, int incomingSampleRate, int outgoingSampleRate, Resampler::Quality quality = Resampler::normal)
+	{
+		jassert(incomingSampleRate > 0 && outgoingSampleRate > 0);
 
-		return returnSignal;
+		return resampleBuffer(audio, incomingSampleRate, outgoingSampleRate, quality);
 	}
+
+protected:
+	// processTakeListParallel, calling finishedFunction on the main thread for each take after its writes, in take order
+	static void runTakePipeline(vector<TAKE>& list, function<void(TAKEJOB&)> perTakeFunction, const Prefetch & prefetch, function<void(TAKEJOB&)> finishedFunction);
 };
@@ -274,37 +274,79 @@ void UPDATE()
 
 
 
-AUDIODATA::AUDIODATA(const vector<vector<double>>& multichannelAudio, int sampleRate, int bitDepth)
+template <typename t> BASIC_AUDIODATA<t>::BASIC_AUDIODATA(const BASIC_AUDIODATA & other)
+	: cues(other.cues), file(other.file), srate(other.srate), bitdepth(other.bitdepth), frames(other.frames),
+	samples(other.samples), channels(other.channels), length(other.length), data(other.data.makeCopy())
+{
+}
+
+template <typename t> BASIC_AUDIODATA<t> & BASIC_AUDIODATA<t>::operator=(const BASIC_AUDIODATA & other)
+{
+	if (this != &other)
+	{
+		cues = other.cues;
+		file = other.file;
+		srate = other.srate;
+		bitdepth = other.bitdepth;
+		frames = other.frames;
+		samples = other.samples;
+		channels = other.channels;
+		length = other.length;
+		data = other.data.makeCopy();
+		peaks.clear();
+	}
+
+	return *this;
+}
+
+template <typename t> BASIC_AUDIODATA<t>::BASIC_AUDIODATA(const vector<vector<double>>& multichannelAudio, int sampleRate, int bitDepth)
 {
 	setSource(multichannelAudio, sampleRate, bitDepth);
 }
 
-AUDIODATA::AUDIODATA(const vector<vector<float>>& multichannelAudio, int sampleRate, int bitDepth)
+template <typename t> BASIC_AUDIODATA<t>::BASIC_AUDIODATA(const vector<vector<float>>& multichannelAudio, int sampleRate, int bitDepth)
 {
-	setSource(convertAudioType<double>(multichannelAudio), sampleRate, bitDepth);
+	setSource(multichannelAudio, sampleRate, bitDepth);
+}
+
+template <typename t> BASIC_AUDIODATA<t>::BASIC_AUDIODATA(const vector<double>& singleChannelAudio, int sampleRate, int bitDepth)
+{
+	if (sampleRate == 0)
+		return;
+
+	copyFrom(singleChannelAudio);
+	srate = sampleRate;
+	bitdepth = bitDepth;
+	updateSizeInfo();
 }
 
-AUDIODATA::AUDIODATA(const vector<double>& singleChannelAudio, int sampleRate, int bitDepth)
+template <typename t> BASIC_AUDIODATA<t>::BASIC_AUDIODATA(const vector<float>& singleChannelAudio, int sampleRate, int bitDepth)
 {
-	setSource(convertAudioType<double>(singleChannelAudio), sampleRate, bitDepth);
+	if (sampleRate == 0)
+		return;
+
+	copyFrom(singleChannelAudio);
+	srate = sampleRate;
+	bitdepth = bitDepth;
+	updateSizeInfo();
 }
 
-AUDIODATA::AUDIODATA(const vector<float>& singleChannelAudio, int sampleRate, int bitDepth)
+template <typename t> BASIC_AUDIODATA<t>::BASIC_AUDIODATA(PlanarBuffer<t> && multichannelAudio, int sampleRate, int bitDepth)
 {
-	setSource(convertAudioType<double>(singleChannelAudio), sampleRate, bitDepth);
+	setSource(std::move(multichannelAudio), sampleRate, bitDepth);
 }
 
-AUDIODATA::AUDIODATA(PCM_source * source)
+template <typename t> BASIC_AUDIODATA<t>::BASIC_AUDIODATA(PCM_source * source)
 {
 	setSource(source);
 }
 
-AUDIODATA::AUDIODATA(const File & file)
+template <typename t> BASIC_AUDIODATA<t>::BASIC_AUDIODATA(const File & file)
 {
 	setSource(file);
 }
 
-void AUDIODATA::setSource(PCM_source * source)
+template <typename t> void BASIC_AUDIODATA<t>::setSource(PCM_source * source)
 {
 	file = source->GetFileName();
 	srate = source->GetSampleRate();
@@ -315,92 +357,161 @@ void AUDIODATA::setSource(PCM_source * source)
 	frames = source->GetLength() * srate;
 }
 
-void AUDIODATA::setSource(const File & file)
+template <typename t> void BASIC_AUDIODATA<t>::setSource(const File & file)
 {
 	setSource(PCM_Source_CreateFromFile(file.getFullPathName().toRawUTF8()));
 }
 
-void AUDIODATA::setSource(const vector<vector<double>> multichannelAudio, int sampleRate, int bitDepth)
+template <typename t> void BASIC_AUDIODATA<t>::setSource(const vector<vector<double>> & multichannelAudio, int sampleRate, int bitDepth)
 {
 	if (sampleRate == 0)
 		return; // take is not audio
 
-	data = multichannelAudio;
+	copyFrom(multichannelAudio);
 	srate = sampleRate;
 	bitdepth = bitDepth;
-	channels = data.size();
-	length = data[0].size() / sampleRate;
-	frames = data[0].size();
-	samples = int(frames * channels * srate);
+	updateSizeInfo();
 }
 
-void AUDIODATA::writeToFile(const File& file) const
+template <typename t> void BASIC_AUDIODATA<t>::setSource(const vector<vector<float>> & multichannelAudio, int sampleRate, int bitDepth)
 {
-	AudioSampleBuffer buffer = convertToAudioSampleBuffer();
+	if (sampleRate == 0)
+		return; // take is not audio
 
-	WavAudioFormat format;
-	std::unique_ptr<AudioFormatWriter> writer;
-	writer.reset(format.createWriterFor(new FileOutputStream(file), srate, buffer.getNumChannels(), bitdepth, {}, 0));
-	if (writer != nullptr)
-		writer->writeFromAudioSampleBuffer(buffer, 0, buffer.getNumSamples());
+	copyFrom(multichannelAudio);
+	srate = sampleRate;
+	bitdepth = bitDepth;
+	updateSizeInfo();
 }
 
-void AUDIODATA::collectCues()
+template <typename t> void BASIC_AUDIODATA<t>::setSource(PlanarBuffer<t> && multichannelAudio, int sampleRate, int bitDepth)
 {
-	cues = WavAudioFile::create(file, 0.0, samples / (double)srate);
+	if (sampleRate == 0)
+		return; // take is not audio
+
+	data = std::move(multichannelAudio);
+	srate = sampleRate;
+	bitdepth = bitDepth;
+	updateSizeInfo();
 }
 
-Array<WavAudioFile::CuePoint> AUDIODATA::getCuePoints()
+template <typename t> void BASIC_AUDIODATA<t>::updateSizeInfo()
+{
+	peaks.clear();
+
+	channels = data.getNumChannels();
+	frames = int(data.getNumFrames());
+	samples = frames * channels;
+	length = srate > 0 ? frames / double(srate) : 0.0;
+}
+
+template <typename t> void BASIC_AUDIODATA<t>::writeToFile(const File& file) const
+{
+	WavAudioFile::write(file, getData(), srate, bitdepth);
+}
+
+template <typename t> void BASIC_AUDIODATA<t>::collectCues()
+{
+	// the whole file, a clip length of 0 runs to its end. A shorter clip would make writeCues truncate the file.
+	cues = WavAudioFile::create(file, 0.0, 0.0);
+}
+
+template <typename t> Array<WavAudioFile::CuePoint> BASIC_AUDIODATA<t>::getCuePoints()
 {
 	return cues->cuePoints;
 }
 
-Array<WavAudioFile::Region> AUDIODATA::getCueRegions()
+template <typename t> Array<WavAudioFile::Region> BASIC_AUDIODATA<t>::getCueRegions()
 {
 	return cues->regions;
 }
 
-Array<WavAudioFile::Loop> AUDIODATA::getLoops()
+template <typename t> Array<WavAudioFile::Loop> BASIC_AUDIODATA<t>::getLoops()
 {
 	return cues->loops;
 }
 
-void AUDIODATA::writeCues()
+template <typename t> void BASIC_AUDIODATA<t>::writeCues()
 {
-	cues->saveChanges(file);
+	// the cues were read from file, so only the metadata chunks need writing
+	cues->saveMetadataChanges();
 }
 
-void AUDIODATA::setSampleRate(int v) { srate = v; }
+template <typename t> void BASIC_AUDIODATA<t>::setSampleRate(int v) { srate = v; }
 
-void AUDIODATA::setBitDepth(int v) { bitdepth = v; }
+template <typename t> void BASIC_AUDIODATA<t>::setBitDepth(int v) { bitdepth = v; }
 
-void AUDIODATA::setNumFrames(int v)
+template <typename t> void BASIC_AUDIODATA<t>::setNumFrames(int v)
 {
-	for (auto & channel : data)
-		channel.resize(v, 0);
+	data.setSize(data.getNumChannels(), v, true);
+	updateSizeInfo();
 }
 
-void AUDIODATA::setNumChannels(int v)
+template <typename t> void BASIC_AUDIODATA<t>::setNumChannels(int v)
 {
-	data.resize(v, vector<double>(data.size(), 0.0));
+	data.setSize(v, data.getNumFrames(), true);
+	updateSizeInfo();
 }
 
-void AUDIODATA::setSample(int channel, int frame, double value)
+template <typename t> void BASIC_AUDIODATA<t>::setSample(int channel, int frame, t value)
 {
-	data[channel][frame] = value;
+	data.getWritePointer(channel)[frame] = value;
+	peaks.clear();
 }
 
-AudioSampleBuffer AUDIODATA::convertToAudioSampleBuffer() const
+template <typename t> const PeakPyramid & BASIC_AUDIODATA<t>::getPeakPyramid() const
 {
-	vector<vector<float>> audio = convertAudioType<float>(data);
+	if (!peaks.isBuilt() && !data.empty())
+		peaks.build(getData());
 
-	AudioSampleBuffer buffer(getNumChannels(), getNumFrames());
-	for (int ch = 0; ch < getNumChannels(); ++ch)
-		buffer.addFrom(ch, 0, audio[ch].data(), audio[ch].size());
+	return peaks;
+}
 
-	return std::move(buffer);
+template <typename t> bool BASIC_AUDIODATA<t>::setPeakPyramid(PeakPyramid && pyramid)
+{
+	if (!pyramid.isBuilt() || pyramid.getNumChannels() != channels || pyramid.getNumFrames() != size_t(frames))
+		return false;
+
+	peaks = std::move(pyramid);
+	return true;
 }
 
+template <typename t> double BASIC_AUDIODATA<t>::getPeakValue(int firstChannel, int numChannels, size_t startFrame, size_t numFrames) const
+{
+	return getPeakPyramid().getPeak(getData(), firstChannel, numChannels, startFrame, numFrames);
+}
+
+template <typename t> double BASIC_AUDIODATA<t>::getRMS(int firstChannel, int numChannels, size_t startFrame, size_t numFrames) const
+{
+	return getPeakPyramid().getRMS(getData(), firstChannel, numChannels, startFrame, numFrames);
+}
+
+template <typename t> bool BASIC_AUDIODATA<t>::isSilent(double minimumAmplitude, int firstChannel, int numChannels, size_t startFrame, size_t numFrames) const
+{
+	if (hasPeakPyramid())
+		return getPeakPyramid().isSilent(getData(), firstChannel, numChannels, startFrame, numFrames, minimumAmplitude);
+
+	// for a single question a scan that stops at the first loud chunk is cheaper than building the pyramid
+	const auto range = getData().getFrameRange(startFrame, numFrames);
+	const int first = jlimit(0, channels, firstChannel);
+	const int last = jlimit(first, channels, firstChannel + numChannels);
+	const size_t chunkSize = 4096;
+
+	for (size_t position = 0; position < range.getNumFrames(); position += chunkSize)
+	{
+		const size_t n = jmin(chunkSize, range.getNumFrames() - position);
+
+		for (int ch = first; ch < last; ++ch)
+			if (PeakSearch::getMaxMagnitude(range.getChannelPointer(ch) + position, n) >= minimumAmplitude)
+				return false;
+	}
+
+	return true;
+}
+
+template class BASIC_AUDIODATA<float>;
+template class BASIC_AUDIODATA<double>;
+
 //double GetNextItemStartTime(double time, TRACKLIST & TrackListIn)
 //{
 //    return 0.0;
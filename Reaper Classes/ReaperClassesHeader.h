@@ -4,6 +4,8 @@
 #include "JuceHeader.h"
 
 #include "../Elan Classes/ElanClassesHeader.h"
+#include <list>
+#include <map>
 #include <set>
 #include <regex>
 
@@ -235,33 +237,49 @@ static regex get_rate_properties(".*?\\n(PLAYRATE .*?)\\n");
 static regex split_rate_properties("PLAYRATE (.*?) (.*?) (.*?) (.*?) (.*?) (.*?)\\n");
 static regex modify_rate_properties("^(.*?\\n)PLAYRATE (.*?) (.*?) (.*?) (.*?) (.*?) (.*?)(\\n.*)$");
 
-class AUDIODATA
+// Audio held in a planar buffer of SampleType, use AUDIODATA (double) or AUDIODATA_FLOAT (float).
+template <typename SampleType> class BASIC_AUDIODATA
 {
 public:
+	using sample_type = SampleType;
+
 	WavAudioFile * cues;
 
-	AUDIODATA() {}
+	BASIC_AUDIODATA() {}
+
+	// Copying makes a deep copy of the sample buffer, prefer moving.
+	BASIC_AUDIODATA(const BASIC_AUDIODATA & other);
+	BASIC_AUDIODATA & operator=(const BASIC_AUDIODATA & other);
+	BASIC_AUDIODATA(BASIC_AUDIODATA && other) = default;
+	BASIC_AUDIODATA & operator=(BASIC_AUDIODATA && other) = default;
+
+	SampleSpan<SampleType> operator[](int i) { return data[i]; }
+	SampleSpan<const SampleType> operator[](int i) const { return data[i]; }
 
-	vector<double>& operator[](int i) { return data[i]; }
-	vector<double> operator[](int i) const { return data[i]; }
+	BASIC_AUDIODATA(const vector<vector<double>> & multichannelAudio, int sampleRate, int bitDepth);
 
-	AUDIODATA(const vector<vector<double>> & multichannelAudio, int sampleRate, int bitDepth);
+	BASIC_AUDIODATA(const vector<vector<float>> & multichannelAudio, int sampleRate, int bitDepth);
 
-	AUDIODATA(const vector<vector<float>> & multichannelAudio, int sampleRate, int bitDepth);
+	BASIC_AUDIODATA(const vector<double> & singleChannelAudio, int sampleRate, int bitDepth);
 
-	AUDIODATA(const vector<double> & singleChannelAudio, int sampleRate, int bitDepth);
+	BASIC_AUDIODATA(const vector<float> & singleChannelAudio, int sampleRate, int bitDepth);
 
-	AUDIODATA(const vector<float> & singleChannelAudio, int sampleRate, int bitDepth);
+	BASIC_AUDIODATA(PlanarBuffer<SampleType> && multichannelAudio, int sampleRate, int bitDepth);
 
-	AUDIODATA(PCM_source* source);
+	BASIC_AUDIODATA(PCM_source* source);
 
-	AUDIODATA(const File & file);
+	BASIC_AUDIODATA(const File & file);
 
 	void setSource(PCM_source* source);
 
 	void setSource(const File & file);
 
-	void setSource(const vector<vector<double>> multichannelAudio, int sampleRate, int bitDepth);
+	void setSource(const vector<vector<double>> & multichannelAudio, int sampleRate, int bitDepth);
+
+	void setSource(const vector<vector<float>> & multichannelAudio, int sampleRate, int bitDepth);
+
+	// Takes ownership of the buffer without copying it
+	void setSource(PlanarBuffer<SampleType> && multichannelAudio, int sampleRate, int bitDepth);
 
 	void writeToFile(const File & file) const;
 
@@ -273,9 +291,12 @@ public:
 
 	// getters
 	File getFile() const { return file; }
-	double getSample(int channel, int sample) { return data[channel][sample]; }
-	vector<double> & getChannel(int channel) { return data[channel]; }
-	vector<vector<double>> & getData() { return data; }
+	SampleType getSample(int channel, int sample) const { return data.getReadPointer(channel)[sample]; }
+	SampleSpan<SampleType> getChannel(int channel) { return data[channel]; }
+	SampleSpan<const SampleType> getChannel(int channel) const { return data[channel]; }
+	MultichannelSpan<SampleType> getData() { return data.getView(); }
+	MultichannelSpan<const SampleType> getData() const { return data.getView(); }
+	PlanarBuffer<SampleType> & getBuffer() { return data; }
 
 	//// separate channels with '|', example 1|2|4, which will return a mono signal mixing channel 1, 2, and 4. NOTE: channels are 1-base. If blank, return full mono mixdown. Optional seconds limits the amount of signal to return.
 	//template <typename t> vector<t> getMonoMixdown(double seconds = 0)
@@ -294,49 +315,21 @@ public:
 	// separate channels with '|', example 1|2|4, which will return a mono signal mixing channel 1, 2, and 4.
 	// NOTE: channels are 1-base. If blank, return full mono mixdown.
 	// Optional seconds limits the amount of signal to return.
-	template <typename t> vector<t> getMixdownViaChannelString(String channelString = "", double seconds = 0)
+	// Builds a MixMatrix from the string on every call, keep a MixMatrix and use mixdown() when mixing repeatedly.
+	template <typename t> vector<t> getMixdownViaChannelString(String channelString = "", double seconds = 0) const
 	{
-		vector<String> channelListString = STR::splitToVector(channelString, "|");
-		vector<int> channelList;
-
-		for (const auto& s : channelListString)
-		{
-			if (!STR::isInt(s))
-			{
-				jassertfalse; // string is not a number
-				continue;
-			}
-
-			int value = s.getIntValue() - 1; // 1 base to 0 base
-
-			if (isPositiveAndBelow(value, getNumChannels()))
-				VectorHelper::pushUnique<int>(channelList, value);
-			else
-				jassertfalse; // invalid channel
-		}
-
-		if (channelList.empty()) // populate with all channels
-			for (int c = 0; c < getNumChannels(); ++c)
-				channelList.push_back(c);
-			//return getMonoMixdown<t>(seconds);
+		const size_t numFrames = seconds > 0 ? size_t(jmin<double>(getSampleRate() * seconds, getNumFrames())) : size_t(getNumFrames());
 
-		int sr = getSampleRate();
-
-		int numFrames = seconds > 0 ? min<int>(getSampleRate() * seconds, getNumFrames()) : getNumFrames();
-
-		vector<t> ret;
-		ret.reserve(numFrames);
-		for (int i = 0; i < numFrames; ++i)
-		{
-			t value = t(0);
+		vector<t> ret(numFrames);
+		mixdown(MixMatrix::fromChannelString(channelString, getNumChannels()), MultichannelSpan<t>(ret.data(), 1, numFrames, numFrames));
 
-			for (auto c : channelList)
-				value += getSample(c, i);
-
-			ret.push_back(value / double(channelList.size()));
-		}
+		return ret;
+	}
 
-		return std::move(ret);
+	// Applies the matrix to frames [startFrame, startFrame + output frames) into the caller's buffer, without allocating
+	template <typename t> void mixdown(const MixMatrix & matrix, MultichannelSpan<t> output, size_t startFrame = 0) const
+	{
+		matrix.apply(getData().getFrameRange(startFrame, output.getNumFrames()), output);
 	}
 
 	int getNumSamples() const { return samples; }
@@ -346,16 +339,32 @@ public:
 	int getBitDepth() const { return bitdepth; }
 	double getLength() const { return length; }
 
+	// Min/max/RMS summary of the samples, built on first use and rebuilt after the audio is replaced.
+	// Call invalidatePeakPyramid() after writing to the samples through getChannel() or getData().
+	// Building isn't thread-safe, call getPeakPyramid() once before sharing the audio between threads.
+	const PeakPyramid & getPeakPyramid() const;
+	void invalidatePeakPyramid() { peaks.clear(); }
+	bool hasPeakPyramid() const { return peaks.isBuilt(); }
+	// Uses a pyramid built elsewhere from these samples, like one read from an AnalysisSidecar. False if its size doesn't match.
+	bool setPeakPyramid(PeakPyramid && pyramid);
+
+	// Peak, RMS and silence over frames [startFrame, startFrame + numFrames) of channels
+	// [firstChannel, firstChannel + numChannels), answered from the peak pyramid. isSilent only
+	// uses the pyramid if it was already built, otherwise it scans until the first loud sample.
+	double getPeakValue(int firstChannel, int numChannels, size_t startFrame = 0, size_t numFrames = size_t(-1)) const;
+	double getRMS(int firstChannel, int numChannels, size_t startFrame = 0, size_t numFrames = size_t(-1)) const;
+	bool isSilent(double minimumAmplitude, int firstChannel, int numChannels, size_t startFrame = 0, size_t numFrames = size_t(-1)) const;
+
 	// setters
 	void setSampleRate(int v);
 	void setBitDepth(int v);
 	void setNumFrames(int v);
 	void setNumChannels(int v);
-	void setSample(int channel, int frame, double value);
+	void setSample(int channel, int frame, SampleType value);
 
 	void clear()
 	{
-		data.clear();
+		data.reset();
 		file = File();
 		srate = 0;
 		bitdepth = 0;
@@ -363,6 +372,7 @@ public:
 		samples = 0;
 		channels = 0;
 		length = 0;
+		peaks.clear();
 	}
 
 protected:
@@ -373,31 +383,33 @@ protected:
 	int samples = 0;
 	int channels = 0;
 	double length = 0;
-	vector<vector<double>> data;
+	PlanarBuffer<SampleType> data;
+	mutable PeakPyramid peaks;
 
-	AudioSampleBuffer convertToAudioSampleBuffer() const;
+	// updates frames, samples and length from the buffer
+	void updateSizeInfo();
 
-	template <typename t1, typename t2> vector<vector<t1>> convertAudioType(const vector<vector<t2>> & type2Audio) const
+	template <typename t> void copyFrom(const vector<vector<t>> & multichannelAudio)
 	{
-		vector<vector<t1>> type1Audio;
-
-		type1Audio.reserve(type2Audio.size());
-		for (int ch = 0; ch < type2Audio.size(); ++ch)
-			type1Audio.push_back({ type2Audio[ch].begin(), type2Audio[ch].end() });
+		data.setSize(int(multichannelAudio.size()), multichannelAudio.empty() ? 0 : multichannelAudio[0].size());
 
-		return std::move(type1Audio);
+		for (int ch = 0; ch < data.getNumChannels(); ++ch)
+		{
+			const size_t n = jmin(multichannelAudio[ch].size(), data.getNumFrames());
+			std::copy(multichannelAudio[ch].begin(), multichannelAudio[ch].begin() + n, data.getWritePointer(ch));
+		}
 	}
 
-	template <typename t1, typename t2> vector<vector<t1>> convertAudioType(const vector<t2> & type2Audio) const
+	template <typename t> void copyFrom(const vector<t> & singleChannelAudio)
 	{
-		vector<vector<t1>> type1Audio;
-
-		type1Audio.push_back({ type2Audio.begin(), type2Audio.end() });
-
-		return std::move(type1Audio);
+		data.setSize(1, singleChannelAudio.size());
+		std::copy(singleChannelAudio.begin(), singleChannelAudio.end(), data.getWritePointer(0));
 	}
 };
 
+using AUDIODATA = BASIC_AUDIODATA<double>;
+using AUDIODATA_FLOAT = BASIC_AUDIODATA<float>;
+
 // Class used to simply add a boolean for if the object is valid or not
 class OBJECT_VALIDATES
 {
@@ -70,12 +70,14 @@ int TAKE::getLastChannel() const
 {
 	int ch = getChannelMode();
 	int first = getFirstChannel();
-
-	if (ch == 0)
-		return GetMediaItemTake_Source(takePtr)->GetNumChannels() - 1;
-	if (ch >= 2 || ch <= 66)
-		return first;
-	return first + 1;
+	int last = GetMediaItemTake_Source(takePtr)->GetNumChannels() - 1;
+
+	// modes asking for more channels than the source has stop at its last one, below first if none are left
+	if (ch >= 3 && ch <= 66) // single channel
+		return jmin(first, last);
+	if (ch != 0)
+		return jmin(first + 1, last); // reverse stereo, mono mix of L+R, or a channel pair
+	return last;
 }
 
 bool TAKE::isPitchPreserved() const { return GetMediaItemTakeInfo_Value(takePtr, "B_PPITCH") != 0; }
@@ -104,6 +106,7 @@ void TAKE::setFile(const File & file)
 	audioFile.clear();
 	audioIsInitialized = false;
 	takeAudioBuffer.clear();
+	takeAudioBufferFloat.clear();
 	takeFrames = 0;
 	takeSamples = 0;
 	audiobuf_starttime = -1;
@@ -245,23 +248,447 @@ void TAKE::initAudio(double starttime, double endtime)
 	takeSamples = takeFrames * audioFile.getNumChannels();
 }
 
-void TAKE::loadAudio()
+template <typename t> void TAKE::readTakeAudio(BASIC_AUDIODATA<t> & destination, bool storeInCache)
 {
+	auto & cache = TAKEAUDIOCACHE::getInstance();
+	const String cacheKey = cache.isEnabled() ? getAudioCacheKey(std::is_same<t, float>::value) : String();
+
+	if (cacheKey.isNotEmpty() && cache.lookup(cacheKey, destination))
+		return;
+
 	// audio accessor is unusuable/bugged unless channel mode is 0
 	int initial_chanmode = getChannelMode();
 	setChannelMode(0);
 
-	vector<double> buffer(takeSamples, 0);
+	const int numChannels = audioFile.getNumChannels();
+	const int sampleRate = audioFile.getSampleRate();
+
+	// one allocation for the whole take, the accessor is read through a small interleaved scratch block
+	PlanarBuffer<t> planar(numChannels, takeFrames);
+
+	const int blockFrames = 65536;
+	vector<double> block(size_t(blockFrames) * numChannels, 0);
+
 	AudioAccessor* accessor = CreateTakeAudioAccessor(takePtr);
-	GetAudioAccessorSamples(accessor, audioFile.getSampleRate(), audioFile.getNumChannels(), audiobuf_starttime, takeFrames, buffer.data());
+
+	for (size_t pos = 0; pos < takeFrames; pos += blockFrames)
+	{
+		const int n = int(jmin<size_t>(blockFrames, takeFrames - pos));
+
+		GetAudioAccessorSamples(accessor, sampleRate, numChannels, audiobuf_starttime + pos / double(sampleRate), n, block.data());
+
+		SampleConverter::deinterleave(block.data(), numChannels, size_t(n), planar.getWritePointer(0) + pos, planar.getStride());
+	}
+
 	DestroyAudioAccessor(accessor);
 
 	setChannelMode(initial_chanmode);
 
-	takeAudioBuffer.setSource(InterleavedToMultichannel(buffer.data(), audioFile.getNumChannels(), takeFrames), audioFile.getSampleRate(), audioFile.getBitDepth());
+	if (storeInCache && cacheKey.isNotEmpty())
+		cache.store(cacheKey, planar, sampleRate, audioFile.getBitDepth());
+
+	destination.setSource(std::move(planar), sampleRate, audioFile.getBitDepth());
+}
+
+String TAKE::getAudioCacheKey(bool isFloat) const
+{
+	// the accessor renders take FX, envelopes and stretch markers, their state isn't part of the key
+	if (TakeFX_GetCount(takePtr) > 0 || CountTakeEnvelopes(takePtr) > 0 || countStretchMarkers() > 0)
+		return {};
+
+	const File file = audioFile.getFile();
+
+	if (!file.existsAsFile())
+		return {};
+
+	// a section or reversed source reads other audio from the same file
+	double sectionOffset = 0, sectionLength = 0;
+	bool isReversed = false;
+	const bool isSection = PCM_Source_GetSectionInfo(getPCMSource(), &sectionOffset, &sectionLength, &isReversed);
+
+	return file.getFullPathName()
+		+ "|" + String(file.getLastModificationTime().toMilliseconds())
+		+ "|" + String(getStartOffset(), 9)
+		+ "|" + String(audiobuf_starttime, 9)
+		+ "|" + String(int64(takeFrames))
+		+ "|" + String(getRate(), 9)
+		+ "|" + String(getPitch(), 9)
+		+ "|" + String(int(isPitchPreserved())) + "|" + String(int(GetMediaItemTakeInfo_Value(takePtr, "I_PITCHMODE")))
+		+ "|" + String(GetMediaItemTakeInfo_Value(takePtr, "D_VOL"), 9)
+		+ "|" + String(GetMediaItemTakeInfo_Value(takePtr, "D_PAN"), 9)
+		+ "|" + String(GetMediaItemTakeInfo_Value(takePtr, "D_PANLAW"), 9)
+		+ "|" + String(getChannelMode())
+		+ (isSection ? "|s" + String(sectionOffset, 9) + "|" + String(sectionLength, 9) + (isReversed ? "|r" : "") : String())
+		+ (isFloat ? "|f" : "|d");
+}
+
+TAKESIDECARS & TAKESIDECARS::getInstance()
+{
+	static TAKESIDECARS instance;
+	return instance;
+}
+
+TAKESIDECARS::TAKESIDECARS()
+	: directory(File::getSpecialLocation(File::userApplicationDataDirectory).getChildFile("seObjectiveReaper").getChildFile("AnalysisCache"))
+{
+}
+
+File TAKESIDECARS::getSourceFile(TAKE & take) const
+{
+	if (!enabled || take.isMidi())
+		return {};
+
+	// an offline source can't be initialised, the take is analysed without its sidecar
+	PCM_source * source = take.getPCMSource();
+
+	if (!take.isAudioInitialized() && source != nullptr && source->IsAvailable())
+		take.initAudio();
+
+	if (!take.isAudioInitialized())
+		return {};
+
+	MediaItem_Take * takePtr = take.getPointer();
+
+	if (TakeFX_GetCount(takePtr) > 0 || CountTakeEnvelopes(takePtr) > 0 || take.countStretchMarkers() > 0)
+		return {};
+
+	double sectionOffset = 0, sectionLength = 0;
+	bool isReversed = false;
+
+	if (PCM_Source_GetSectionInfo(source, &sectionOffset, &sectionLength, &isReversed))
+		return {};
+
+	if (take.getStartOffset() != 0 || take.getRate() != 1 || take.getPitch() != 0 || take.getChannelMode() != 0
+		|| GetMediaItemTakeInfo_Value(takePtr, "D_VOL") != 1 || GetMediaItemTakeInfo_Value(takePtr, "D_PAN") != 0)
+		return {};
+
+	// the item length rounds to within a frame of the file
+	const int64 fileFrames = take.audioFile.getNumFrames();
+
+	if (take.audiobuf_starttime != 0 || std::abs(int64(take.takeFrames) - fileFrames) > 1)
+		return {};
+
+	const File file = take.audioFile.getFile();
+
+	return file.existsAsFile() ? file : File();
+}
+
+bool TAKESIDECARS::load(const File & source, AnalysisSidecar & sidecar) const
+{
+	return sidecar.load(source, directory);
+}
+
+void TAKESIDECARS::update(const File & source, std::function<void(AnalysisSidecar &)> change) const
+{
+	AnalysisSidecar sidecar;
+
+	if (!load(source, sidecar))
+		sidecar.clear();
+
+	change(sidecar);
+	sidecar.save(source, directory);
+}
+
+bool TAKESIDECARS::loadPeaks(const File & source, AUDIODATA & audio) const
+{
+	AnalysisSidecar sidecar;
+	return load(source, sidecar) && audio.setPeakPyramid(std::move(sidecar.peaks));
+}
+
+bool TAKESIDECARS::loadLoudness(const File & source, double timeWindowForPeakRMS, LoudnessMeter::Result & result) const
+{
+	AnalysisSidecar sidecar;
+
+	if (!load(source, sidecar) || !sidecar.loudness.isValid || sidecar.rmsWindowSeconds != timeWindowForPeakRMS)
+		return false;
+
+	result = sidecar.loudness;
+	return true;
+}
+
+bool TAKESIDECARS::loadOnsets(const File & source, const OnsetDetector::Settings & settings, vector<double> & result) const
+{
+	AnalysisSidecar sidecar;
+
+	if (!load(source, sidecar) || !sidecar.hasOnsets || sidecar.onsetSettingsHash != settings.getHash())
+		return false;
+
+	result = std::move(sidecar.onsets);
+	return true;
+}
+
+void TAKESIDECARS::storePeaks(const File & source, const PeakPyramid & peaks) const
+{
+	update(source, [&](AnalysisSidecar & sidecar) { sidecar.peaks = peaks; });
+}
+
+void TAKESIDECARS::storeLoudness(const File & source, double timeWindowForPeakRMS, const LoudnessMeter::Result & result) const
+{
+	update(source, [&](AnalysisSidecar & sidecar)
+	{
+		sidecar.loudness = result;
+		sidecar.rmsWindowSeconds = timeWindowForPeakRMS;
+	});
+}
+
+void TAKESIDECARS::storeOnsets(const File & source, const OnsetDetector::Settings & settings, const vector<double> & result) const
+{
+	update(source, [&](AnalysisSidecar & sidecar)
+	{
+		sidecar.hasOnsets = true;
+		sidecar.onsetSettingsHash = settings.getHash();
+		sidecar.onsets = result;
+	});
+}
+
+bool TAKESOURCESTATE::setOnline(const TAKE & take)
+{
+	PCM_source * source = take.getPCMSource();
+	++apiCalls;
+
+	if (source == nullptr)
+		return false;
+
+	if (changed.find(source) != changed.end())
+		return true;
+
+	const bool wasAvailable = source->IsAvailable();
+	++apiCalls;
+
+	if (!wasAvailable)
+	{
+		source->SetAvailable(true);
+		++apiCalls;
+	}
+
+	changed[source] = wasAvailable;
+	return true;
+}
+
+void TAKESOURCESTATE::restore(const TAKE & take)
+{
+	PCM_source * source = take.getPCMSource();
+	++apiCalls;
+
+	auto it = changed.find(source);
+
+	if (it == changed.end())
+		return;
+
+	if (!it->second)
+	{
+		source->SetAvailable(false);
+		++apiCalls;
+	}
+
+	changed.erase(it);
+}
+
+void TAKESOURCESTATE::restoreAll()
+{
+	for (const auto & c : changed)
+	{
+		if (!c.second)
+		{
+			c.first->SetAvailable(false);
+			++apiCalls;
+		}
+	}
+
+	changed.clear();
+}
+
+TAKEAUDIOCACHE & TAKEAUDIOCACHE::getInstance()
+{
+	static TAKEAUDIOCACHE instance;
+	return instance;
 }
 
-void TAKE::unloadAudio() { takeAudioBuffer.clear(); }
+template <typename t> bool TAKEAUDIOCACHE::lookup(const String & key, BASIC_AUDIODATA<t> & destination)
+{
+	PlanarBuffer<t> copy;
+	int sampleRate = 0, bitDepth = 0;
+
+	{
+		const ScopedLock sl(lock);
+
+		auto it = index.find(key);
+
+		if (it == index.end())
+		{
+			++misses;
+			return false;
+		}
+
+		// move to the front, it is now the most recently used
+		entries.splice(entries.begin(), entries, it->second);
+
+		copy = getBuffer(*it->second, t()).makeCopy();
+		sampleRate = it->second->sampleRate;
+		bitDepth = it->second->bitDepth;
+	}
+
+	++hits;
+
+	destination.setSource(std::move(copy), sampleRate, bitDepth);
+	return true;
+}
+
+template <typename t> void TAKEAUDIOCACHE::store(const String & key, const PlanarBuffer<t> & audio, int sampleRate, int bitDepth)
+{
+	const size_t bytes = audio.getSizeInBytes();
+
+	if (bytes == 0 || bytes > maxBytes)
+		return;
+
+	// copied outside the lock, other threads may be reading the cache meanwhile
+	Entry entry;
+	entry.key = key;
+	getBuffer(entry, t()) = audio.makeCopy();
+	entry.sampleRate = sampleRate;
+	entry.bitDepth = bitDepth;
+	entry.bytes = bytes;
+
+	std::list<Entry> evicted;
+
+	const ScopedLock sl(lock);
+
+	auto existing = index.find(key);
+	if (existing != index.end())
+	{
+		usedBytes -= existing->second->bytes;
+		evicted.splice(evicted.begin(), entries, existing->second);
+		index.erase(existing);
+	}
+
+	evictToFit(bytes);
+
+	entries.push_front(std::move(entry));
+	index[key] = entries.begin();
+	usedBytes += bytes;
+}
+
+template bool TAKEAUDIOCACHE::lookup(const String &, BASIC_AUDIODATA<double> &);
+template bool TAKEAUDIOCACHE::lookup(const String &, BASIC_AUDIODATA<float> &);
+template void TAKEAUDIOCACHE::store(const String &, const PlanarBuffer<double> &, int, int);
+template void TAKEAUDIOCACHE::store(const String &, const PlanarBuffer<float> &, int, int);
+
+void TAKEAUDIOCACHE::evictToFit(size_t bytes)
+{
+	while (!entries.empty() && usedBytes + bytes > maxBytes)
+	{
+		usedBytes -= entries.back().bytes;
+		index.erase(entries.back().key);
+		entries.pop_back();
+	}
+}
+
+void TAKEAUDIOCACHE::clear()
+{
+	const ScopedLock sl(lock);
+
+	entries.clear();
+	index.clear();
+	usedBytes = 0;
+}
+
+void TAKEAUDIOCACHE::setMaxBytes(size_t bytes)
+{
+	const ScopedLock sl(lock);
+
+	maxBytes = bytes;
+	evictToFit(0);
+}
+
+size_t TAKEAUDIOCACHE::getUsedBytes() const
+{
+	const ScopedLock sl(lock);
+	return usedBytes;
+}
+
+int TAKEAUDIOCACHE::getNumEntries() const
+{
+	const ScopedLock sl(lock);
+	return int(entries.size());
+}
+
+void TAKE::loadAudio(bool storeInCache)
+{
+	// only one of the buffers is loaded, so whichever was loaded last is the one analysed
+	takeAudioBufferFloat.clear();
+	readTakeAudio(takeAudioBuffer, storeInCache);
+}
+
+void TAKE::loadAudioAsFloat(bool storeInCache)
+{
+	takeAudioBuffer.clear();
+	readTakeAudio(takeAudioBufferFloat, storeInCache);
+}
+
+TAKEBLOCKREADER::TAKEBLOCKREADER(TAKE & take, int firstChannel, int numChannels, int blockSize)
+	: take(take), firstChannel(firstChannel), numChannels(numChannels), blockSize(blockSize)
+{
+	if (!take.isAudioInitialized())
+		take.initAudio();
+
+	if (!take.isAudioInitialized())
+		return;
+
+	numSourceChannels = take.getNumChannels();
+	sampleRate = take.getSampleRate();
+	startTime = take.audiobuf_starttime;
+	totalFrames = take.getNumFrames();
+
+	jassert(firstChannel >= 0 && firstChannel + numChannels <= numSourceChannels); // channel range outside of source
+
+	this->numChannels = jlimit(0, jmax(0, numSourceChannels - firstChannel), numChannels);
+
+	interleaved.resize(size_t(blockSize) * numSourceChannels, 0);
+	block.setSize(numSourceChannels, blockSize);
+
+	// audio accessor is unusuable/bugged unless channel mode is 0
+	initialChannelMode = take.getChannelMode();
+	take.setChannelMode(0);
+	channelModeChanged = true;
+
+	accessor = CreateTakeAudioAccessor(take.getPointer());
+}
+
+TAKEBLOCKREADER::~TAKEBLOCKREADER()
+{
+	if (accessor != nullptr)
+		DestroyAudioAccessor(accessor);
+
+	// also when the accessor couldn't be created
+	if (channelModeChanged)
+		take.setChannelMode(initialChannelMode);
+}
+
+bool TAKEBLOCKREADER::readNext(int numFrames)
+{
+	blockFrames = 0;
+
+	if (accessor == nullptr || isFinished())
+		return false;
+
+	const int n = int(jmin<size_t>(jmin(numFrames, blockSize), totalFrames - position));
+
+	GetAudioAccessorSamples(accessor, sampleRate, numSourceChannels, startTime + position / double(sampleRate), n, interleaved.data());
+
+	SampleConverter::deinterleave(interleaved.data(), numSourceChannels, size_t(n), block.getWritePointer(0), block.getStride());
+
+	blockStart = position;
+	blockFrames = n;
+	position += n;
+
+	return n > 0;
+}
+
+void TAKE::unloadAudio()
+{
+	takeAudioBuffer.clear();
+	takeAudioBufferFloat.clear();
+}
 
 bool TAKE::isAudioInitialized() { return audioIsInitialized; }
 
@@ -273,25 +700,94 @@ int TAKE::getNumChannels() { return audioFile.getNumChannels(); }
 
 int TAKE::getNumChannelModeChannels()
 {
-	return getLastChannel() - getFirstChannel() + 1;
+	return jmax(0, getLastChannel() - getFirstChannel() + 1);
+}
+
+MixMatrix TAKE::getChannelModeMixMatrix()
+{
+	const int numChannels = getNumChannels();
+	const int mode = getChannelMode();
+
+	if (mode == 1) // reverse stereo
+	{
+		MixMatrix m(numChannels, 2);
+		if (numChannels >= 2)
+		{
+			m.setGain(0, 1, 1.0);
+			m.setGain(1, 0, 1.0);
+		}
+		return m;
+	}
+
+	if (mode == 2) // mono, mix of L+R
+		return MixMatrix::average(0, 2, numChannels);
+
+	return MixMatrix::select(getFirstChannel(), getNumChannelModeChannels(), numChannels);
 }
 
 size_t TAKE::getNumFrames() const { return takeFrames; }
 
 size_t TAKE::getNumSamples() const { return takeSamples; }
 
-vector<vector<double>> & TAKE::getAudioMultichannel() { return takeAudioBuffer.getData(); }
+MultichannelSpan<double> TAKE::getAudioMultichannel() { return takeAudioBuffer.getData(); }
+
+MultichannelSpan<float> TAKE::getAudioMultichannelFloat() { return takeAudioBufferFloat.getData(); }
 
-vector<double>& TAKE::getAudioChannel(int channel)
+SampleSpan<double> TAKE::getAudioChannel(int channel)
 {
+	jassert(takeAudioBuffer.getNumFrames() > 0); // loadAudio() wasn't called, the take may be loaded as float
 	return takeAudioBuffer[channel];
 }
 
 double TAKE::getSample(int channel, int frame)
 {
+	jassert(takeAudioBuffer.getNumFrames() > 0);
 	return takeAudioBuffer[channel][frame];
 }
 
+void TAKE::getFrameRange(double startTime, double endTime, size_t & startFrame, size_t & numFrames)
+{
+	const double sr = getSampleRate();
+	const size_t total = isFloatAudioLoaded() ? size_t(takeAudioBufferFloat.getNumFrames()) : size_t(takeAudioBuffer.getNumFrames());
+
+	startFrame = jmin(total, size_t(jmax(0.0, startTime) * sr));
+	const size_t endFrame = endTime < 0 ? total : jlimit(startFrame, total, size_t(endTime * sr));
+	numFrames = endFrame - startFrame;
+}
+
+double TAKE::getPeakValue(double startTime, double endTime)
+{
+	size_t start, length;
+	getFrameRange(startTime, endTime, start, length);
+
+	if (isFloatAudioLoaded())
+		return takeAudioBufferFloat.getPeakValue(getFirstChannel(), getNumChannelModeChannels(), start, length);
+
+	return takeAudioBuffer.getPeakValue(getFirstChannel(), getNumChannelModeChannels(), start, length);
+}
+
+double TAKE::getRMS(double startTime, double endTime)
+{
+	size_t start, length;
+	getFrameRange(startTime, endTime, start, length);
+
+	if (isFloatAudioLoaded())
+		return takeAudioBufferFloat.getRMS(getFirstChannel(), getNumChannelModeChannels(), start, length);
+
+	return takeAudioBuffer.getRMS(getFirstChannel(), getNumChannelModeChannels(), start, length);
+}
+
+bool TAKE::isSilent(double minimumAmplitude, double startTime, double endTime)
+{
+	size_t start, length;
+	getFrameRange(startTime, endTime, start, length);
+
+	if (isFloatAudioLoaded())
+		return takeAudioBufferFloat.isSilent(minimumAmplitude, getFirstChannel(), getNumChannelModeChannels(), start, length);
+
+	return takeAudioBuffer.isSilent(minimumAmplitude, getFirstChannel(), getNumChannelModeChannels(), start, length);
+}
+
 double TAKE::getProjectPositionForFrameIndex(int index)
 {
 	return getStart() + index / getSampleRate();
@@ -446,14 +942,30 @@ vector<TAKEMARKER> TAKEMARKER::collect(TAKE& take, bool ignoreMarkersOutsideItem
 
 void TAKEMARKER::replace(TAKE& take, vector<TAKEMARKER>& list)
 {
-	int i = 0;
-	while (DeleteTakeMarker(take.getPointer(), i))
-		++i;
+	// from the back, deleting shifts the indices of the markers after it
+	for (int i = TAKEMARKER::count(take) - 1; i >= 0; --i)
+		DeleteTakeMarker(take.getPointer(), i);
 
 	for (auto& m : list)
 		TAKEMARKER::add(take, m.position, m.name, m.color);
 }
 
+void TAKEMARKER::replacePreset(TAKE& take, const MarkerPreset& preset, const vector<double>& positions)
+{
+	auto list = TAKEMARKER::collect(take, false);
+
+	list.erase(std::remove_if(list.begin(), list.end(), [&](const TAKEMARKER& m) { return m.name == preset.name; }), list.end());
+
+	const int color = juceToReaperColor(preset.color);
+
+	for (double position : positions)
+		list.emplace_back(take, -1, position, preset.name, color);
+
+	std::stable_sort(list.begin(), list.end(), [](const TAKEMARKER& a, const TAKEMARKER& b) { return a.position < b.position; });
+
+	TAKEMARKER::replace(take, list);
+}
+
 int TAKEMARKER::count(TAKE& take)
 {
 	return GetNumTakeMarkers(take.getPointer());
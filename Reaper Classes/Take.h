@@ -157,8 +157,13 @@ public:
 
 	static vector<TAKEMARKER> collect(TAKE& take, bool ignoreMarkersOutsideItem = true);
 
+	// Deletes all markers of the take and adds the list
 	static void replace(TAKE& take, vector<TAKEMARKER>& list);
 
+	// Replaces the markers named like the preset with markers at the given positions, local time, keeping all others.
+	// Reads the markers once and rewrites them with one replace(), instead of a collect() per marker like addOrUpdateByName.
+	static void replacePreset(TAKE& take, const MarkerPreset& preset, const vector<double>& positions);
+
 	static int count(TAKE& take);
 
 	// local time
@@ -218,6 +223,8 @@ class TAKE : public OBJECT_MOVABLE, public OBJECT_NAMABLE, public OBJECT_VALIDAT
 	friend class ITEM;
 	friend class MIDINOTE;
 	friend class MIDINOTELIST;
+	friend class TAKEBLOCKREADER;
+	friend class TAKESIDECARS;
 
 public:
 	TAKE() {}
@@ -234,7 +241,12 @@ public:
 	bool operator!=(const MediaItem_Take * rhs) const { return takePtr != rhs; }
 	bool operator==(const TAKE & rhs) const { return takePtr == rhs.takePtr; }
 	bool operator!=(const TAKE & rhs) const { return takePtr != rhs.takePtr; }
-	vector<double>& operator[](int i) { return takeAudioBuffer[i]; }
+	// double audio from loadAudio(), after loadAudioAsFloat() use getTakeAudioFloat()
+	SampleSpan<double> operator[](int i)
+	{
+		jassert(takeAudioBuffer.getNumFrames() > 0);
+		return takeAudioBuffer[i];
+	}
 
 	struct envelope
 	{
@@ -312,26 +324,46 @@ public:
 	}
 
 	void initAudio(double starttime = -1, double endtime = -1);
-	void loadAudio();
+	// Looks in TAKEAUDIOCACHE first. A decode is stored there too, which copies it, unless storeInCache
+	// is false, for audio that is read once like in the batch functions of AUDIOFUNCTION and AUDIOPROCESS.
+	void loadAudio(bool storeInCache = true);
+	// Loads the take as 32 bit float samples, half the memory of loadAudio(). See getTakeAudioFloat().
+	// Either one unloads what the other loaded.
+	void loadAudioAsFloat(bool storeInCache = true);
 	void unloadAudio();
 	bool isAudioInitialized();
 
 	AUDIODATA& getAudioFile();
 	AUDIODATA& getTakeAudio() { return takeAudioBuffer; }
+	AUDIODATA_FLOAT& getTakeAudioFloat() { return takeAudioBufferFloat; }
+	// true if the take audio was loaded with loadAudioAsFloat()
+	bool isFloatAudioLoaded() const { return takeAudioBufferFloat.getNumFrames() > 0; }
 	int getSampleRate();
 	int getBitDepth();
 	// return total channels for source audio
 	int getNumChannels();
 	// return number of active channels based on channel mode
 	int getNumChannelModeChannels();
+	// Maps all source channels, the layout of the loaded audio, to what the channel mode plays:
+	// all channels, a reversed pair, the L+R average, one channel or a pair
+	MixMatrix getChannelModeMixMatrix();
 	size_t getNumFrames() const;
 	size_t getNumSamples() const;
 
-	vector<vector<double>> & getAudioMultichannel();
-	vector<double> & getAudioChannel(int channel);
+	MultichannelSpan<double> getAudioMultichannel();
+	MultichannelSpan<float> getAudioMultichannelFloat();
+	// these two read the double audio of loadAudio()
+	SampleSpan<double> getAudioChannel(int channel);
 	double getSample(int channel, int frame);
 	double getProjectPositionForFrameIndex(int index);
 
+	// Peak, RMS and silence of the loaded audio's channel mode channels between two times in seconds
+	// from the take start, an end time of -1 is the end of the take. Answered from the peak pyramid
+	// of whichever of loadAudio() or loadAudioAsFloat() was called.
+	double getPeakValue(double startTime = 0, double endTime = -1);
+	double getRMS(double startTime = 0, double endTime = -1);
+	bool isSilent(double minimumAmplitude, double startTime = 0, double endTime = -1);
+
 	bool isValid() const override;
 
 protected:
@@ -342,15 +374,237 @@ protected:
 	bool audioIsInitialized = false;
 
 	AUDIODATA takeAudioBuffer;
+	AUDIODATA_FLOAT takeAudioBufferFloat;
 	size_t takeFrames = 0;
 	size_t takeSamples = 0;
 	double audiobuf_starttime = -1;
 	double audiobuf_endtime = -1;
 
+	template <typename t> void readTakeAudio(BASIC_AUDIODATA<t> & destination, bool storeInCache);
+
+	// frame range of a time range for the peak queries
+	void getFrameRange(double startTime, double endTime, size_t & startFrame, size_t & numFrames);
+
+	// key for TAKEAUDIOCACHE, empty if the decoded audio can't be shared (take FX, envelopes, stretch markers, no source file)
+	String getAudioCacheKey(bool isFloat) const;
+
 	String getObjectName() const override;
 	void setObjectName(const String & v) override;
 };
 
+/*
+Reads take audio block by block through an audio accessor instead of decoding the whole take,
+so only one block is held in memory and analysis can stop as soon as it has its answer.
+
+TAKEBLOCKREADER reader(take, take.getFirstChannel(), take.getNumChannelModeChannels());
+while (reader.readNextBlock())
+	for (int ch = 0; ch < reader.getNumChannels(); ++ch)
+		for (double sample : reader[ch]) ...
+
+Uses the REAPER API, so it must be used on the main thread. The take's channel mode is
+set to 0 while the reader exists because the audio accessor misbehaves otherwise.
+*/
+class TAKEBLOCKREADER
+{
+public:
+	TAKEBLOCKREADER(TAKE & take, int firstChannel, int numChannels, int blockSize = 4096);
+	~TAKEBLOCKREADER();
+
+	TAKEBLOCKREADER(const TAKEBLOCKREADER &) = delete;
+	TAKEBLOCKREADER & operator=(const TAKEBLOCKREADER &) = delete;
+
+	// Reads the next getBlockSize() frames. Returns false once the end of the take is reached.
+	bool readNextBlock() { return readNext(blockSize); }
+
+	// Reads the next numFrames frames (at most getBlockSize()). Returns false once the end of the take is reached.
+	bool readNext(int numFrames);
+
+	// Moves the read position, in frames from the start of the take
+	void seek(size_t frame) { position = jmin(frame, totalFrames); }
+
+	// current block, only valid until the next read
+	MultichannelSpan<const double> getBlock() const { return block.getView().getChannelRange(firstChannel, numChannels).getFrameRange(0, blockFrames); }
+	SampleSpan<const double> operator[](int channel) const { return getBlock()[channel]; }
+
+	// frame index, relative to the take, of the first frame in the current block
+	size_t getBlockStart() const { return blockStart; }
+	int getBlockFrames() const { return blockFrames; }
+	int getBlockSize() const { return blockSize; }
+	int getFirstChannel() const { return firstChannel; }
+	int getNumChannels() const { return numChannels; }
+	int getSampleRate() const { return sampleRate; }
+	size_t getPosition() const { return position; }
+	size_t getTotalFrames() const { return totalFrames; }
+	bool isFinished() const { return position >= totalFrames; }
+	bool isValid() const { return accessor != nullptr; }
+
+protected:
+	TAKE & take;
+	AudioAccessor * accessor = nullptr;
+	int initialChannelMode = 0;
+	bool channelModeChanged = false;
+
+	int firstChannel = 0;
+	int numChannels = 0;
+	int numSourceChannels = 0;
+	int sampleRate = 0;
+	int blockSize = 0;
+	double startTime = 0;
+
+	size_t totalFrames = 0;
+	size_t position = 0;
+	size_t blockStart = 0;
+	int blockFrames = 0;
+
+	vector<double> interleaved;
+	PlanarBuffer<double> block; // every source channel, deinterleaving all of them is cheaper than picking some out
+};
+
+/*
+Decoded take audio shared between TAKE objects. TAKE::loadAudio and loadAudioAsFloat look here
+before reading through an audio accessor, so many items sliced from one file, or the same take
+loaded again, are decoded once.
+
+Entries are keyed by source file and modification time, take start offset, length, playrate,
+pitch, preserve pitch and pitch mode, volume, pan, channel mode and the section and reverse state
+of the source, and evicted least recently used first once the byte budget is exceeded. Takes with
+FX, envelopes or stretch markers aren't cached. Hits copy the cached buffer, which is a memcpy
+instead of a decode. Storing copies the decode as well, so batch passes that read every take once
+don't store.
+
+TAKEAUDIOCACHE::getInstance().setMaxBytes(1 << 30);
+...
+DBG(TAKEAUDIOCACHE::getInstance().getNumHits());
+*/
+class TAKEAUDIOCACHE
+{
+public:
+	static TAKEAUDIOCACHE & getInstance();
+
+	// copies the cached audio into destination, false on a miss
+	template <typename t> bool lookup(const String & key, BASIC_AUDIODATA<t> & destination);
+	template <typename t> void store(const String & key, const PlanarBuffer<t> & audio, int sampleRate, int bitDepth);
+
+	void clear();
+
+	void setEnabled(bool v) { enabled = v; }
+	bool isEnabled() const { return enabled; }
+
+	// evicts entries until the cache fits, an entry larger than the budget is never stored
+	void setMaxBytes(size_t bytes);
+	size_t getMaxBytes() const { return maxBytes; }
+	size_t getUsedBytes() const;
+	int getNumEntries() const;
+
+	int64 getNumHits() const { return hits.get(); }
+	int64 getNumMisses() const { return misses.get(); }
+	void resetCounters() { hits = 0; misses = 0; }
+
+protected:
+	struct Entry
+	{
+		String key;
+		PlanarBuffer<double> doubleAudio;
+		PlanarBuffer<float> floatAudio;
+		int sampleRate = 0;
+		int bitDepth = 0;
+		size_t bytes = 0;
+	};
+
+	static PlanarBuffer<double> & getBuffer(Entry & e, double) { return e.doubleAudio; }
+	static PlanarBuffer<float> & getBuffer(Entry & e, float) { return e.floatAudio; }
+
+	void evictToFit(size_t bytes);
+
+	CriticalSection lock;
+	std::list<Entry> entries; // most recently used first
+	std::map<String, std::list<Entry>::iterator> index;
+	size_t usedBytes = 0;
+	size_t maxBytes = size_t(512) << 20;
+	bool enabled = true;
+
+	Atomic<int64> hits, misses;
+};
+
+/*
+AnalysisSidecar files of takes that play their whole source file unchanged: no start offset, the
+file's full length, playrate 1, no pitch shift, unity volume, centre pan, channel mode 0, no section
+or reverse, no take FX, envelopes or stretch markers. Such a take reads exactly the file's samples, so its peak
+pyramid, loudness and onsets are stored per file and reused by any such take of the file until the
+file changes. AUDIOFUNCTION's peak, loudness and onset functions look here before reading audio.
+
+Sidecars go to a cache in the user's application data folder, setDirectory(File()) puts them next
+to the source files. Uses the REAPER API and the disk, main thread only.
+*/
+class TAKESIDECARS
+{
+public:
+	static TAKESIDECARS & getInstance();
+
+	void setEnabled(bool v) { enabled = v; }
+	bool isEnabled() const { return enabled; }
+
+	void setDirectory(const File & v) { directory = v; }
+	const File & getDirectory() const { return directory; }
+
+	// the source file if sidecars are enabled and the take plays all of it unchanged, File() otherwise
+	File getSourceFile(TAKE & take) const;
+
+	// the load functions are false if the sidecar is missing, out of date or doesn't hold the result
+	bool loadPeaks(const File & source, AUDIODATA & audio) const;
+	bool loadLoudness(const File & source, double timeWindowForPeakRMS, LoudnessMeter::Result & result) const;
+	bool loadOnsets(const File & source, const OnsetDetector::Settings & settings, vector<double> & result) const;
+
+	// the store functions keep the other results in the sidecar
+	void storePeaks(const File & source, const PeakPyramid & peaks) const;
+	void storeLoudness(const File & source, double timeWindowForPeakRMS, const LoudnessMeter::Result & result) const;
+	void storeOnsets(const File & source, const OnsetDetector::Settings & settings, const vector<double> & result) const;
+
+protected:
+	TAKESIDECARS();
+
+	bool enabled = true;
+	File directory;
+
+	bool load(const File & source, AnalysisSidecar & sidecar) const;
+	// loads the sidecar, or starts an empty one if that fails, lets change modify it and saves it
+	void update(const File & source, std::function<void(AnalysisSidecar &)> change) const;
+};
+
+/*
+Brings the sources of takes online for reading and puts them back the way they were, through
+PCM_source::SetAvailable. Unlike the set items online/offline actions it touches only the takes
+it is given and leaves the item selection alone, so it costs the same in a project of any size.
+Sources still changed are put back when the object is destroyed.
+
+TAKESOURCESTATE sources;
+sources.setOnline(take);
+take.loadAudio();
+sources.restore(take);
+*/
+class TAKESOURCESTATE
+{
+public:
+	TAKESOURCESTATE() {}
+	~TAKESOURCESTATE() { restoreAll(); }
+
+	TAKESOURCESTATE(const TAKESOURCESTATE &) = delete;
+	TAKESOURCESTATE & operator=(const TAKESOURCESTATE &) = delete;
+
+	// brings the take's source online if it is offline, false if the take has no source
+	bool setOnline(const TAKE & take);
+
+	// puts the take's source back the way it was before setOnline
+	void restore(const TAKE & take);
+	void restoreAll();
+
+	// REAPER API calls made so far, for AUDIOPROCESS::benchmarkTakeLoading
+	int64 getNumApiCalls() const { return apiCalls; }
+
+protected:
+	std::map<PCM_source *, bool> changed; // sources set online, with whether they were available before
+	int64 apiCalls = 0;
+};
 
 class TAKELIST : public LIST<TAKE>
 {
@@ -118,22 +118,11 @@ void PluginChain::render(MediaItem * item, double sr, String outfn)
 			while (count < lenframes)
 			{
 				GetAudioAccessorSamples(accessor, sr, outchans, (double)count/sr, bufsize, buf.data());
-				for (int i = 0; i < outchans; ++i)
-				{
-					for (int j = 0; j < bufsize; ++j)
-					{
-						plugbufptrs[i][j] = buf[j*outchans + i];
-					}
-				}
+				SampleConverter::deinterleave(buf.data(), outchans, bufsize, plugbufptrs);
 				for (auto& e : m_plugins)
 					e.m_plug->processBlock(plugprocbuf, midibuf);
 				for (int i = 0; i < outchans; ++i)
-				{
-					for (int j = 0; j < bufsize; ++j)
-					{
-						diskoutbufptrs[i][j] = plugbufptrs[i][j];
-					}
-				}
+					SampleConverter::convert(plugbufptrs[i], diskoutbufptrs[i], bufsize);
 				sink->WriteDoubles(diskoutbufptrs, bufsize, outchans, 0, 1);
 				count += bufsize;
 			}
@@ -188,26 +177,23 @@ void PluginChain::render(std::vector<std::vector<double>>& buf, double sr, int b
 		if (cancel_flag != nullptr && *cancel_flag == true)
 			break;
 		int framesto_output = std::min<int64_t>(blocksize, lenframes - inposcount);
+		// input frames left for this block, the rest of the block is zero padding for the latency tail
+		int framesto_input = (int)jlimit<int64_t>(0, framesto_output, inputlenframes - inposcount);
 		for (int i = 0; i < outchans; ++i)
 		{
-			for (int j = 0; j < blocksize; ++j)
-			{
-				if (j<framesto_output && inposcount+j<inputlenframes)
-					plugbufptrs[i][j] = buf[i][inposcount+j];
-				else plugbufptrs[i][j] = 0.0;
-			}
+			if (framesto_input > 0)
+				SampleConverter::convert(buf[i].data() + inposcount, plugbufptrs[i], framesto_input);
+			FloatVectorOperations::clear(plugbufptrs[i] + framesto_input, blocksize - framesto_input);
 		}
 		for (auto& e : m_plugins)
 			e.m_plug->processBlock(plugprocbuf, midibuf);
+		// the first total_latency output frames are dropped
+		int framesto_skip = (int)jlimit<int64_t>(0, framesto_output, total_latency - inposcount);
 		for (int i = 0; i < outchans; ++i)
 		{
-			for (int j = 0; j < framesto_output; ++j)
-			{
-				if (inposcount + j >= total_latency)
-				{
-					buf[i][inposcount + j - total_latency] = plugbufptrs[i][j];
-				}
-			}
+			if (framesto_output > framesto_skip)
+				SampleConverter::convert(plugbufptrs[i] + framesto_skip, buf[i].data() + inposcount + framesto_skip - total_latency,
+					framesto_output - framesto_skip);
 		}
 		inposcount += blocksize;
 		if (progress != nullptr)
@@ -699,9 +685,8 @@ String renderFileWithChain(String chainfn, String infn, String outfn)
 			transfer.samples = readbuf.data();
 			src->GetSamples(&transfer);
 			delete src;
-			for (int i = 0; i < numoutchans; ++i)
-				for (int j = 0; j < lenframes; ++j)
-					procbuf[i][j] = readbuf[j * numoutchans + i];
+			double* procbufptrs[2] = { procbuf[0].data(), procbuf[1].data() };
+			SampleConverter::deinterleave(readbuf.data(), numoutchans, lenframes, procbufptrs);
 			chain->render(procbuf, outsr);
 			auto sink = createPCMSink(outfn, "WAV", 32,
 				numoutchans, outsr);
@@ -847,13 +832,8 @@ void renderFolderWithChainMultithreaded(String chainfn, String indir, String out
 				transfer.samples = readbuf.data();
 				src->GetSamples(&transfer);
 				delete src;
-				for (int j = 0; j < numoutchans; ++j)
-				{
-					for (int k = 0; k < lenframes; ++k)
-					{
-						buffers[i][j][k] = readbuf[k*numoutchans + j];
-					}
-				}
+				double* bufferptrs[2] = { buffers[i][0].data(), buffers[i][1].data() };
+				SampleConverter::deinterleave(readbuf.data(), numoutchans, lenframes, bufferptrs);
 			}
 			//else
 			//	showConsoleMsg("Could not open " + filestoprocess[i] + " for reading");
@@ -1,8 +1,22 @@
 #include "seObjectiveReaper.h"
 
 #include "Elan Classes/maths.cpp"
+#include "Elan Classes/SampleConversion.cpp"
 #include "Elan Classes/Audio.cpp"
+#include "Elan Classes/WavMetadata.cpp"
+#include "Elan Classes/AudioReaderPool.cpp"
 #include "Elan Classes/SignalFunctions.cpp"
+#include "Elan Classes/PeakPyramid.cpp"
+#include "Elan Classes/PeakSearch.cpp"
+#include "Elan Classes/Loudness.cpp"
+#include "Elan Classes/AnalysisSidecar.cpp"
+#include "Elan Classes/WorkerPool.cpp"
+#include "Elan Classes/SilenceDetector.cpp"
+#include "Elan Classes/RealFFT.cpp"
+#include "Elan Classes/OnsetDetector.cpp"
+#include "Elan Classes/PitchDetector.cpp"
+#include "Elan Classes/Resampler.cpp"
+#include "Elan Classes/MixMatrix.cpp"
 
 #include "Reaper Classes/ReaperClassesHeader.cpp"
 #include "Reaper Classes/Env.cpp"